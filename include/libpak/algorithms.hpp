@@ -20,7 +20,13 @@
 #ifndef LIBPAK_ALGORITHMS_HPP
 #define LIBPAK_ALGORITHMS_HPP
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
 
 namespace libpak::alg
 {
@@ -33,6 +39,63 @@ namespace libpak::alg
  */
 int32_t alicia_checksum(const char* buffer, uint64_t length);
 
+/**
+ * Perform CRC32 on the capitalized string.
+ * @param string String
+ * @return CRC32
+ */
+uint32_t capitalized_string_crc32(std::string_view string);
+
+/**
+ * Compress buffer with zlib.
+ * @param source        Buffer
+ * @param source_length Buffer length
+ * @param buffer        Compressed buffer, resized to the compressed data length
+ * @param level         Compression level
+ * @throws std::runtime_error
+ */
+void compress(const std::byte* source, uint64_t source_length, std::vector<std::byte>& buffer, int level);
+
+/**
+ * Decompress zlib compressed buffer.
+ * @param source        Compressed buffer
+ * @param source_length Compressed buffer length
+ * @param buffer        Decompressed buffer
+ * @param length        Decompressed buffer length
+ * @return Length of the decompressed data
+ * @throws std::runtime_error
+ */
+uint64_t decompress(const std::byte* source, uint64_t source_length, std::byte* buffer, uint64_t length);
+
+/**
+ * Decompress the embedded data of an asset.
+ * @param source              Embedded data
+ * @param source_length       Embedded data length
+ * @param decompressed_length Decompressed data length of the asset header
+ * @param buffer              Decompressed buffer, resized to the decompressed data length
+ * @throws std::runtime_error
+ */
+template <typename Buffer>
+void decompress_embedded_data(
+  const std::byte* source,
+  const uint64_t source_length,
+  const uint64_t decompressed_length,
+  Buffer& buffer)
+{
+  // NPAK can compress small buffers and inflate them. Because to this,
+  // choose the largest data size for the decompressed data buffer.
+  try
+  {
+    buffer.resize(std::max(source_length, decompressed_length));
+  }
+  catch (std::bad_alloc&)
+  {
+    throw std::runtime_error("not enough memory for data buffer");
+  }
+
+  buffer.resize(decompress(source, source_length, buffer.data(), buffer.size()));
+}
+
 } // namespace libpak::alg
 
 
@@ -0,0 +1,123 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#ifndef LIBPAK_BUILDER_HPP
+#define LIBPAK_BUILDER_HPP
+
+#include "definitions.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+namespace libpak
+{
+
+/**
+ * Options of a resource build.
+ */
+struct build_options
+{
+  /**
+   * Directory whose files are packed. Asset paths are relative to it.
+   */
+  std::filesystem::path source_directory;
+
+  /**
+   * Path to the built resource.
+   */
+  std::filesystem::path output_path;
+
+  /**
+   * PAK header template. The asset counts and the file size are filled in.
+   */
+  libpak::pak_header pak_header{};
+
+  /**
+   * Content header template. The asset count is filled in.
+   */
+  libpak::content_header content_header{
+    .first_magic = 0x534C4946,  // ASCII: FILS
+    .second_magic = 0x5A4C4946, // ASCII: FILZ
+  };
+
+  /**
+   * Compression levels indexed by the lowercase file extension including the dot,
+   * e.g. `.dds`. Level 0 stores the data uncompressed.
+   */
+  std::unordered_map<std::string, int> compression_levels;
+
+  /**
+   * Compression level of the files whose extension has no compression level.
+   */
+  int default_compression_level{9};
+
+  /**
+   * Number of worker threads. Hardware concurrency is used if zero.
+   */
+  uint32_t threads{0};
+
+  /**
+   * Maximum number of file and compressed bytes in flight.
+   * A file larger than the budget is packed alone.
+   */
+  uint64_t memory_budget{256 * 1024 * 1024};
+};
+
+/**
+ * Result of a resource build.
+ */
+struct build_result
+{
+  /**
+   * Number of packed assets.
+   */
+  uint32_t assets_count{};
+
+  /**
+   * Number of bytes read from the files.
+   */
+  uint64_t input_bytes{};
+
+  /**
+   * Number of embedded bytes written to the resource.
+   */
+  uint64_t embedded_bytes{};
+
+  /**
+   * Number of input bytes packed per second.
+   */
+  double throughput{};
+};
+
+/**
+ * Builds a resource from the files of a directory. The directory is walked in parallel,
+ * files are read and compressed by a pool of workers and the resource is written in
+ * a single sequential pass, in the order of the asset paths. Symlinked directories
+ * are skipped, symlinked files are packed with the contents of their target.
+ * @param options Build options.
+ * @return Build result.
+ * @throws std::runtime_error
+ */
+build_result build(const build_options& options);
+
+} // namespace libpak
+
+#endif // LIBPAK_BUILDER_HPP
@@ -0,0 +1,98 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#ifndef LIBPAK_COMPRESSION_PLANNER_HPP
+#define LIBPAK_COMPRESSION_PLANNER_HPP
+
+#include "definitions.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace libpak
+{
+
+//! Compression level which stores the data uncompressed.
+static constexpr int STORED_COMPRESSION_LEVEL = 0;
+
+//! Compression level used when there is no compression goal.
+static constexpr int DEFAULT_COMPRESSION_LEVEL = 9;
+
+/**
+ * Goal of a compression plan. There is no goal if neither the time budget nor
+ * the size target is set, and every asset is compressed at the default level.
+ */
+struct compression_goal
+{
+  /**
+   * Time the compression of all assets may take. Unlimited if zero.
+   */
+  std::chrono::milliseconds time_budget{0};
+
+  /**
+   * Total embedded size the compression should reach. Unlimited if zero.
+   */
+  uint64_t size_target{0};
+
+  /**
+   * @return True if a time budget or a size target is set, otherwise returns false.
+   */
+  bool is_set() const noexcept { return time_budget.count() > 0 || size_target > 0; }
+};
+
+/**
+ * Compression plan of a set of assets.
+ */
+struct compression_plan
+{
+  /**
+   * Compression levels in the order of the planned assets. Assets whose data
+   * aren't compressed are planned at the stored level.
+   */
+  std::vector<int> levels;
+
+  /**
+   * Predicted total embedded size.
+   */
+  uint64_t predicted_size{};
+
+  /**
+   * Predicted time of the compression.
+   */
+  std::chrono::nanoseconds predicted_time{};
+};
+
+/**
+ * Plans the compression levels of the assets to meet the goal. A few slices of every
+ * compressed asset are compressed at each candidate level to estimate its ratio, and the
+ * compression speed of each level is measured on all of the slices together. Starting with
+ * every asset stored, the assets are then compressed at higher levels in the order of the
+ * bytes saved per second spent, while the size is above the target and the time budget
+ * is not exceeded. The sampling time counts against the time budget.
+ * @param assets Assets with their data.
+ * @param goal   Compression goal.
+ * @return Compression plan.
+ */
+compression_plan plan_compression(std::span<const asset* const> assets, const compression_goal& goal);
+
+} // namespace libpak
+
+#endif // LIBPAK_COMPRESSION_PLANNER_HPP
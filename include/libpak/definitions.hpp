@@ -134,10 +134,17 @@ struct asset
    */
   asset_data data{};
 
+  /**
+   * Whether the data are meant to be compressed, but were last written uncompressed
+   * at the stored compression level. The header then describes the stored data, and
+   * the data are compressed again by a write at any other level.
+   */
+  bool is_compression_skipped = false;
+
   /**
    * @return String view of the asset path.
    */
-  std::u16string path() { return header.path; }
+  std::u16string path() const { return header.path; }
 
   /**
    * Mark the asset as patched.
@@ -0,0 +1,108 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#ifndef LIBPAK_EXTRACT_HPP
+#define LIBPAK_EXTRACT_HPP
+
+#include "libpak.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+
+namespace libpak
+{
+
+/**
+ * Progress of an extraction.
+ */
+struct extract_progress
+{
+  /**
+   * Number of extracted assets.
+   */
+  uint32_t extracted_assets{};
+
+  /**
+   * Number of assets to extract.
+   */
+  uint32_t total_assets{};
+
+  /**
+   * Number of extracted embedded bytes.
+   */
+  uint64_t extracted_bytes{};
+
+  /**
+   * Number of embedded bytes to extract.
+   */
+  uint64_t total_bytes{};
+
+  /**
+   * Number of extracted embedded bytes per second.
+   */
+  double throughput{};
+};
+
+/**
+ * Options of an extraction.
+ */
+struct extract_options
+{
+  /**
+   * Directory the assets are extracted to.
+   */
+  std::filesystem::path output_directory;
+
+  /**
+   * Filter selecting the assets to extract. All assets are extracted if empty.
+   */
+  std::function<bool(const asset&)> filter;
+
+  /**
+   * Number of worker threads. Hardware concurrency is used if zero.
+   */
+  uint32_t threads{0};
+
+  /**
+   * Maximum number of embedded and decompressed bytes in flight.
+   * An asset larger than the budget is extracted alone.
+   */
+  uint64_t memory_budget{256 * 1024 * 1024};
+
+  /**
+   * Called from the worker threads after each extracted asset. Calls are serialized.
+   */
+  std::function<void(const extract_progress&)> progress;
+};
+
+/**
+ * Extracts the assets of the resource to a directory. The embedded data are read in the
+ * order of their offset, and are decompressed and written to files by a pool of workers.
+ * The asset data buffers of the resource are left untouched.
+ * @param resource Resource. Must be read.
+ * @param options  Extraction options.
+ * @return Extraction progress once finished.
+ * @throws std::runtime_error
+ */
+extract_progress extract(resource& resource, const extract_options& options);
+
+} // namespace libpak
+
+#endif // LIBPAK_EXTRACT_HPP
@@ -0,0 +1,174 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#ifndef LIBPAK_HEADER_RANGE_HPP
+#define LIBPAK_HEADER_RANGE_HPP
+
+#include "definitions.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <ranges>
+#include <vector>
+
+namespace libpak
+{
+
+//! Default number of asset headers read from the header table at once.
+static constexpr size_t HEADER_RANGE_CHUNK_SIZE = 256;
+
+/**
+ * Single pass range over the header table of a resource. The headers are read
+ * lazily in chunks into a fixed buffer, so the memory use doesn't grow with
+ * the number of assets and nothing is allocated per header. The range can be
+ * composed with the standard views and the enumeration can stop at any point.
+ *
+ * The headers are yielded in the order of the header table, deleted assets included.
+ * A yielded header is valid until the iterator is incremented.
+ */
+class header_range
+  : public std::ranges::view_interface<header_range>
+{
+public:
+  /**
+   * Iterator over the headers.
+   */
+  class iterator
+  {
+  public:
+    using iterator_concept = std::input_iterator_tag;
+    using value_type = asset_header;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+
+    explicit iterator(header_range* range)
+      : range(range)
+    {
+    }
+
+    const asset_header& operator*() const { return this->range->current(); }
+    const asset_header* operator->() const { return &this->range->current(); }
+
+    /**
+     * Advances to the next header.
+     * @throws std::runtime_error
+     */
+    iterator& operator++()
+    {
+      this->range->advance();
+      return *this;
+    }
+
+    void operator++(int) { ++*this; }
+
+    friend bool operator==(const iterator& position, std::default_sentinel_t)
+    {
+      return position.is_end();
+    }
+
+  private:
+    bool is_end() const { return this->range == nullptr || this->range->is_exhausted(); }
+
+    header_range* range{nullptr};
+  };
+
+  /**
+   * Opens the resource and reads its content header.
+   * @param path       Path to resource.
+   * @param chunk_size Number of headers read at once.
+   * @throws std::runtime_error
+   */
+  explicit header_range(const std::filesystem::path& path, size_t chunk_size = HEADER_RANGE_CHUNK_SIZE);
+
+  header_range(header_range&&) = default;
+  header_range& operator=(header_range&&) = default;
+
+  /**
+   * Reads the first chunk of headers. May be called only once.
+   * @return Iterator at the first header.
+   * @throws std::runtime_error
+   */
+  iterator begin();
+
+  /**
+   * @return Sentinel after the last header.
+   */
+  std::default_sentinel_t end() const noexcept { return std::default_sentinel; }
+
+  /**
+   * Content header of the resource.
+   */
+  content_header content_header{};
+
+private:
+  /**
+   * @return Current header.
+   */
+  const asset_header& current() const { return this->chunk[this->chunk_index]; }
+
+  /**
+   * Advances to the next header, reads the next chunk if the current one is consumed.
+   * @throws std::runtime_error
+   */
+  void advance();
+
+  /**
+   * Reads the next chunk of headers.
+   * @throws std::runtime_error
+   */
+  void read_chunk();
+
+  /**
+   * @return True if all of the headers were enumerated, otherwise returns false.
+   */
+  bool is_exhausted() const noexcept { return this->chunk_index >= this->chunk.size(); }
+
+  /**
+   * Resource input stream.
+   */
+  std::ifstream input;
+
+  /**
+   * Buffer of the current chunk.
+   */
+  std::vector<asset_header> chunk;
+
+  /**
+   * Index of the current header in the chunk.
+   */
+  size_t chunk_index{};
+
+  /**
+   * Number of headers read from the header table.
+   */
+  uint32_t headers_read{};
+
+  /**
+   * Number of headers read at once.
+   */
+  size_t chunk_size{};
+};
+
+} // namespace libpak
+
+#endif // LIBPAK_HEADER_RANGE_HPP
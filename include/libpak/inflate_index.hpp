@@ -0,0 +1,109 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#ifndef LIBPAK_INFLATE_INDEX_HPP
+#define LIBPAK_INFLATE_INDEX_HPP
+
+#include "definitions.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace libpak
+{
+
+//! Default distance between two inflate checkpoints in decompressed bytes.
+static constexpr uint64_t INFLATE_CHECKPOINT_SPAN = 1024 * 1024;
+
+//! Size of the inflate window.
+static constexpr uint64_t INFLATE_WINDOW_SIZE = 32 * 1024;
+
+/**
+ * Represents a point in the compressed data from which inflating can be resumed.
+ */
+struct inflate_checkpoint
+{
+  /**
+   * Offset in the decompressed data.
+   */
+  uint64_t decompressed_offset{};
+
+  /**
+   * Offset of the first full byte in the embedded data.
+   */
+  uint64_t embedded_offset{};
+
+  /**
+   * Number of bits of the byte preceding the embedded offset which belong to the checkpoint.
+   */
+  int32_t bits{};
+
+  /**
+   * Decompressed data preceding the checkpoint, used as the inflate dictionary.
+   */
+  std::vector<std::byte> window;
+};
+
+/**
+ * Represents the inflate checkpoints of a compressed asset.
+ */
+struct inflate_index
+{
+  /**
+   * Offset of the embedded data the index was built from.
+   */
+  uint64_t embedded_data_offset{};
+
+  /**
+   * Length of the embedded data the index was built from.
+   */
+  uint64_t embedded_data_length{};
+
+  /**
+   * CRC of the embedded data the index was built from.
+   */
+  uint32_t crc_embedded{};
+
+  /**
+   * Length of the decompressed data.
+   */
+  uint64_t decompressed_length{};
+
+  /**
+   * Checkpoints ordered by their decompressed offset.
+   */
+  std::vector<inflate_checkpoint> checkpoints;
+
+  /**
+   * @param header Asset header.
+   * @return True if the index was built from the embedded data of the asset,
+   * otherwise returns false.
+   */
+  bool is_built_from(const asset_header& header) const noexcept
+  {
+    return embedded_data_offset == header.embedded_data_offset
+      && embedded_data_length == header.embedded_data_length
+      && crc_embedded == header.crc_embedded;
+  }
+};
+
+} // namespace libpak
+
+#endif // LIBPAK_INFLATE_INDEX_HPP
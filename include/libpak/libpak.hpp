@@ -20,17 +20,53 @@
 #ifndef libpak_libpak_HPP
 #define libpak_libpak_HPP
 
+#include "compression_planner.hpp"
 #include "definitions.hpp"
+#include "header_range.hpp"
+#include "inflate_index.hpp"
 
 #include <fstream>
 #include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 
 namespace libpak
 {
 
-using asset_map = std::unordered_map<std::u16string, asset>;
+/**
+ * Hashes asset paths, allows lookups by any string convertible to a string view.
+ */
+struct asset_path_hash
+{
+  using is_transparent = void;
+
+  size_t operator()(const std::u16string_view path) const noexcept
+  {
+    return std::hash<std::u16string_view>{}(path);
+  }
+};
+
+/**
+ * Compares asset paths, allows lookups by any string convertible to a string view.
+ */
+struct asset_path_equal
+{
+  using is_transparent = void;
+
+  bool operator()(const std::u16string_view lhs, const std::u16string_view rhs) const noexcept
+  {
+    return lhs == rhs;
+  }
+};
+
+/**
+ * Map of assets indexed by their path. The keys and the asset data are regular strings
+ * and vectors, only the nodes and the buckets of the map come from its memory resource.
+ */
+using asset_map = std::pmr::unordered_map<std::u16string, asset, asset_path_hash, asset_path_equal>;
 
 /**
  * Provides encapsulation for read and write operations on streams.
@@ -136,6 +172,83 @@ public:
   std::shared_ptr<std::ostream> sink;
 };
 
+/**
+ * Result of a resource compaction.
+ */
+struct compaction_result
+{
+  /**
+   * Number of bytes reclaimed from the resource file.
+   */
+  uint64_t reclaimed_bytes{};
+
+  /**
+   * Number of deleted assets dropped from the header table.
+   */
+  uint32_t dropped_assets{};
+
+  /**
+   * Whether an interrupted compaction was resumed.
+   */
+  bool resumed{};
+};
+
+/**
+ * Options of a resource write.
+ */
+struct write_options
+{
+  /**
+   * Whether assets with identical data share their embedded data.
+   * Duplicates are found by the CRC of their data and confirmed by comparing the data.
+   * Assets share the embedded data of the original regardless of their compression flag,
+   * the data are compressed if the original was compressed.
+   */
+  bool deduplicate{false};
+
+  /**
+   * Goal the compression levels of the assets are planned for. Every compressed asset
+   * is compressed at the default level if no goal is set.
+   */
+  compression_goal compression{};
+};
+
+/**
+ * Result of a resource write.
+ */
+struct write_result
+{
+  /**
+   * Number of assets sharing the embedded data of another asset.
+   */
+  uint32_t deduplicated_assets{};
+
+  /**
+   * Number of embedded bytes saved by deduplication.
+   */
+  uint64_t deduplicated_bytes{};
+
+  /**
+   * Number of data bytes of the written assets.
+   */
+  uint64_t input_bytes{};
+
+  /**
+   * Number of embedded bytes written to the resource.
+   */
+  uint64_t embedded_bytes{};
+
+  /**
+   * Ratio of the embedded bytes to the data bytes.
+   */
+  double compression_ratio{};
+
+  /**
+   * Number of data bytes written per second.
+   */
+  double throughput{};
+};
+
 /**
  * Represents a single resource which holds assets and their accompanying data.
  */
@@ -146,14 +259,54 @@ public:
    * Default constructor.
    * @param path Path to resource.
    * @param create Whether to create the resource.
+   * @param use_arena Whether to allocate the nodes of the asset index from a monotonic
+   * arena owned by the resource. The arena is released at once when the resource is destroyed.
+   * The arena only grows, the memory of replaced or erased assets is reclaimed by destroy() only.
+   * It suits a resource which is read once, destroy() it before reading it again.
    */
-  explicit resource(std::string path, bool create = true)
+  explicit resource(std::string path, bool create = true, bool use_arena = false)
     : resource_path(std::move(path))
+    , arena(use_arena ? std::make_unique<std::pmr::monotonic_buffer_resource>() : nullptr)
+    , assets(arena != nullptr ? arena.get() : std::pmr::get_default_resource())
   {
     if (create)
       this->create();
   };
 
+  /**
+   * Copy constructor. The copy shares the resource streams. The asset index is copied
+   * to an arena of the copy if the resource uses one.
+   * @param other Resource.
+   */
+  resource(const resource& other);
+  resource(resource&&) = default;
+
+  /**
+   * Copy assignment operator.
+   * @param other Resource.
+   * @return Resource.
+   */
+  resource& operator=(const resource& other);
+
+  /**
+   * Move assignment operator. The asset index keeps the arena it was allocated from.
+   * @param other Resource.
+   * @return Resource.
+   */
+  resource& operator=(resource&& other) noexcept;
+
+  /**
+   * Destroys the resource.
+   */
+  ~resource() { this->destroy(); }
+
+  /**
+   * Opens the resource and reads its headers, without indexing the assets.
+   * Assets whose headers are known can be read afterwards.
+   * @throws std::runtime_error
+   */
+  void open();
+
   /**
    * Reads the resource and indexes the assets.
    * @param data Whether to read the data of the indexed assets.
@@ -179,10 +332,81 @@ public:
   void read_asset_data(asset& asset);
 
   /**
-   * Writes the resource.
+   * Reads assets embedded data from the resource without decompressing them.
+   * @param asset  Asset. Must contain a valid data offset.
+   * @param buffer Buffer for the embedded data.
+   * @throws std::runtime_error
+   */
+  void read_asset_embedded_data(const asset& asset, std::vector<std::byte>& buffer);
+
+  /**
+   * Reads a range of the assets data from the resource. Only the range is read for
+   * uncompressed assets. Compressed assets are inflated from the nearest checkpoint
+   * of their cached inflate index, or from the start if they have none.
+   * @param asset  Asset. Must contain a valid data offset.
+   * @param offset Offset in the decompressed data.
+   * @param length Length of the range. The range is truncated at the end of the data.
+   * @return Data of the range.
+   * @throws std::runtime_error
+   */
+  std::vector<std::byte> read(const asset& asset, uint64_t offset, uint64_t length);
+
+  /**
+   * Builds the inflate index of a compressed asset and caches it in the inflate indices.
+   * @param asset Asset. Must contain a valid data offset.
+   * @param span  Distance between two checkpoints in decompressed bytes.
+   * @return Inflate index.
+   * @throws std::runtime_error
+   */
+  std::shared_ptr<const inflate_index> build_inflate_index(
+    const asset& asset,
+    uint64_t span = INFLATE_CHECKPOINT_SPAN);
+
+  /**
+   * Hints that the embedded data of the assets will be read soon, so that they are read
+   * ahead into the page cache. Adjacent data ranges are coalesced into larger requests.
+   * @param assets Assets. Must contain a valid data offset.
+   * @return Number of bytes hinted.
+   * @throws std::runtime_error
+   */
+  uint64_t prefetch(const std::vector<const asset*>& assets);
+
+  /**
+   * Hints that the embedded data of the assets in the directory will be read soon.
+   * @param directory Directory path, the assets in its subdirectories are included.
+   * @return Number of bytes hinted.
+   * @throws std::runtime_error
+   */
+  uint64_t prefetch(std::u16string_view directory);
+
+  /**
+   * Enumerates the asset headers of the resource lazily, without indexing the assets.
+   * The resource doesn't have to be read.
+   * @param chunk_size Number of headers read at once.
+   * @return Single pass range over the headers.
+   * @throws std::runtime_error
+   */
+  header_range headers(size_t chunk_size = HEADER_RANGE_CHUNK_SIZE) const;
+
+  /**
+   * Writes the resource to the resource path.
+   * @param options Write options.
+   * @return Write result.
+   * @throws std::runtime_error
+   */
+  write_result write(const write_options& options = {});
+
+  /**
+   * Writes the resource. The resource is staged in a temporary file next to the target,
+   * which is synced and then atomically renamed over the target. The target is left
+   * untouched if the write fails.
+   * @param path    Path to the target. May differ from the resource path, so that the
+   * resource can be read from while it is being written.
+   * @param options Write options.
+   * @return Write result.
    * @throws std::runtime_error
    */
-  void write();
+  write_result write(const std::string& path, const write_options& options = {});
 
   /**
    * Writes the asset header.
@@ -194,8 +418,29 @@ public:
   /**
    * Writes the asset's data.
    * @param asset Asset.
+   * @param level Compression level of compressed data. The data are stored uncompressed
+   * if the level is the stored level, the header is marked as such and the asset remembers
+   * the skipped compression (see asset::is_compression_skipped).
+   * @param data_crc CRC of the asset data, computed if not given.
+   */
+  void write_asset_data(
+    asset& asset,
+    int level = DEFAULT_COMPRESSION_LEVEL,
+    std::optional<uint32_t> data_crc = std::nullopt);
+
+  /**
+   * Compacts the resource in place. Deleted assets are dropped from the header table and
+   * the embedded data of the live assets is moved down to close the gaps. The compressed
+   * data is copied verbatim.
+   *
+   * Progress is recorded in a journal next to the resource (`<resource_path>.compact`).
+   * If a compaction is interrupted, the next call resumes it from the journal. The journal
+   * and the resource are synced before each journal update, so that a power failure is
+   * recovered from as well as a killed process.
+   * @return Compaction result.
+   * @throws std::runtime_error
    */
-  void write_asset_data(asset& asset);
+  compaction_result compact();
 
   /**
    * Create the resource file descriptors.
@@ -213,7 +458,7 @@ public:
    * @param name Asset name.
    * @return Indexed asset.
    */
-  asset& operator[](const std::u16string& name) { return this->assets.at(name); }
+  asset& operator[](std::u16string_view name);
 
   /**
    * Path to resource.
@@ -234,11 +479,26 @@ public:
    */
   data_header data_header;
 
+  /**
+   * Arena the nodes of the asset index are allocated from, if enabled.
+   */
+  std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+
   /**
    * Map of all assets indexed by their name.
    */
   asset_map assets;
 
+  /**
+   * Cached inflate indices of compressed assets indexed by their name.
+   */
+  std::unordered_map<std::u16string, std::shared_ptr<const inflate_index>> inflate_indices;
+
+  /**
+   * Buffer for the embedded data of compressed assets, reused between reads.
+   */
+  std::vector<std::byte> embedded_buffer;
+
   /**
    * Resource stream.
    */
@@ -0,0 +1,159 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#ifndef LIBPAK_PATCH_HPP
+#define LIBPAK_PATCH_HPP
+
+#include "libpak.hpp"
+
+#include <cstdint>
+#include <filesystem>
+
+namespace libpak::patch
+{
+
+#pragma pack(push, 1)
+
+/**
+ * Represents patch header.
+ */
+struct patch_header
+{
+  uint32_t magic{0x48435450}; // ASCII: PTCH
+  uint32_t version{2};
+
+  //! Physical size of the source resource.
+  uint64_t source_size{};
+  //! Physical size of the target resource.
+  uint64_t target_size{};
+
+  libpak::pak_header pak_header{};
+  libpak::content_header content_header{};
+
+  //! Number of patch references.
+  uint32_t references_count{};
+  //! Number of patch entries.
+  uint32_t entries_count{};
+  //! Length of the deflated table of patch references and patch entries.
+  uint64_t table_length{};
+};
+
+/**
+ * Represents patch reference. A target asset whose header is the header of a source asset,
+ * apart from its header and embedded data offsets, is referenced instead of being stored
+ * as a patch entry.
+ */
+struct patch_reference
+{
+  //! Index of the source asset header in the header table of the source resource.
+  uint32_t source_index{};
+  //! Offset of the target asset header.
+  uint32_t header_offset{};
+  //! Offset of the target asset embedded data.
+  uint32_t embedded_data_offset{};
+};
+
+/**
+ * Represents patch entry. There is a patch entry for every target asset which is new or
+ * changed, or whose header differs from the header of the source asset.
+ */
+struct patch_entry
+{
+  /**
+   * Origin of the embedded data.
+   */
+  enum class origin : uint32_t
+  {
+    //! Asset has no embedded data.
+    none = 0,
+    //! Embedded data are copied from the source resource.
+    source = 1,
+    //! Embedded data are stored in the patch.
+    patch = 2,
+  };
+
+  //! Target asset header.
+  asset_header header{};
+
+  origin data_origin{origin::none};
+  //! Offset of the embedded data in the source resource or in the data of the patch.
+  uint64_t data_offset{};
+};
+
+#pragma pack(pop)
+
+/**
+ * Result of a patch generation.
+ */
+struct generate_result
+{
+  /**
+   * Number of assets whose embedded data are copied from the source resource.
+   */
+  uint32_t unchanged_assets{};
+
+  /**
+   * Number of assets whose embedded data are stored in the patch.
+   */
+  uint32_t changed_assets{};
+
+  /**
+   * Number of source assets which are not present in the target resource.
+   */
+  uint32_t removed_assets{};
+
+  /**
+   * Size of the patch.
+   */
+  uint64_t patch_size{};
+};
+
+/**
+ * Generates a patch which transforms the source resource into the target resource.
+ * Assets are matched by their path and compared by their embedded and decompressed CRCs,
+ * no asset data are decompressed. Only the headers and embedded data of new or changed
+ * assets are stored in the patch, unchanged assets are stored as references to the source
+ * assets. The table of references and entries is deflated.
+ *
+ * The patch is laid out as follows:
+ * - patch_header
+ * - deflated patch references followed by the patch entries
+ * - embedded data of the new or changed assets
+ * @param source     Source resource. Must be read.
+ * @param target     Target resource. Must be read.
+ * @param patch_path Path to the patch.
+ * @return Generation result.
+ * @throws std::runtime_error
+ */
+generate_result generate(resource& source, resource& target, const std::filesystem::path& patch_path);
+
+/**
+ * Applies a patch to the source resource and writes the target resource.
+ * The layout of the target resource is reconstructed exactly and the embedded data
+ * of every asset is verified against its embedded CRC.
+ * @param source      Source resource. Must be read.
+ * @param patch_path  Path to the patch.
+ * @param target_path Path to the target resource. Must differ from the source resource path.
+ * @throws std::runtime_error
+ */
+void apply(resource& source, const std::filesystem::path& patch_path, const std::filesystem::path& target_path);
+
+} // namespace libpak::patch
+
+#endif // LIBPAK_PATCH_HPP
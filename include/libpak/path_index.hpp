@@ -0,0 +1,114 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#ifndef LIBPAK_PATH_INDEX_HPP
+#define LIBPAK_PATH_INDEX_HPP
+
+#include "libpak.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace libpak
+{
+
+/**
+ * Index for matching asset paths against globs and prefixes. The paths are matched
+ * case-insensitively and both `/` and `\` are treated as separators.
+ *
+ * The uppercase paths are kept in one contiguous arena and are compared with SIMD
+ * instructions where available. Assets whose extension and parent path hashes agree
+ * with their path are pruned by the hashes before their paths are compared.
+ *
+ * The index refers to the assets of the resource and is invalidated when they change.
+ */
+class path_index
+{
+public:
+  /**
+   * Builds the index of the assets of the resource.
+   * @param resource Resource. Must be read.
+   */
+  explicit path_index(const resource& resource);
+
+  /**
+   * Matches the asset paths against a glob. `?` matches a character and `*` matches
+   * any characters except a separator. `**` matches any characters, `**` followed by
+   * a separator matches any number of directories, including none.
+   * @param pattern Glob.
+   * @return Matching assets, in the order of their embedded data offset.
+   */
+  //! E.g. `libconfig/**/*.xml` matches the XML files in `libconfig` and in all of its directories.
+  std::vector<const asset*> match_glob(std::u16string_view pattern) const;
+
+  /**
+   * Matches the asset paths against a prefix.
+   * @param prefix Prefix.
+   * @return Matching assets, in the order of their embedded data offset.
+   */
+  std::vector<const asset*> match_prefix(std::u16string_view prefix) const;
+
+private:
+  /**
+   * Represents an indexed asset.
+   */
+  struct entry
+  {
+    //! Offset of the uppercase path in the path arena.
+    uint32_t path_offset{};
+    //! Length of the path.
+    uint32_t path_length{};
+
+    //! Extension hash of the asset header.
+    uint32_t extension_hash{};
+    //! Parent path hash of the asset header.
+    uint32_t parent_path_hash{};
+
+    //! Whether the extension hash agrees with the path.
+    bool is_extension_hash_trusted{};
+    //! Whether the parent path hash agrees with the path.
+    bool is_parent_path_hash_trusted{};
+    //! Whether the path separator of the asset is a backslash.
+    bool is_backslash_separated{};
+
+    const libpak::asset* asset{};
+  };
+
+  /**
+   * @param entry Entry.
+   * @return Uppercase path of the entry.
+   */
+  std::u16string_view path(const entry& entry) const noexcept;
+
+  /**
+   * Uppercase paths of the indexed assets, separated by slashes.
+   */
+  std::u16string paths;
+
+  /**
+   * Indexed assets, in the order of their embedded data offset.
+   */
+  std::vector<entry> entries;
+};
+
+} // namespace libpak
+
+#endif // LIBPAK_PATH_INDEX_HPP
@@ -0,0 +1,221 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#ifndef LIBPAK_RELOADABLE_HPP
+#define LIBPAK_RELOADABLE_HPP
+
+#include "libpak.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace libpak
+{
+
+/**
+ * Options of a reloadable resource.
+ */
+struct reload_options
+{
+  /**
+   * Interval in which the resource file is checked for changes.
+   * The resource is reloaded only on demand if zero.
+   */
+  std::chrono::milliseconds poll_interval{1000};
+
+  /**
+   * Whether to read the data of the assets into the snapshots.
+   * Otherwise the data are read on demand through resource_snapshot::read_data().
+   */
+  bool read_data{false};
+
+  /**
+   * Whether the snapshots allocate their asset index from an arena.
+   */
+  bool use_arena{false};
+
+  /**
+   * Called from the watcher thread when a reload fails. The previous snapshot stays published.
+   */
+  std::function<void(const std::exception&)> on_error;
+};
+
+/**
+ * Snapshot of a reloadable resource.
+ */
+class resource_snapshot : public resource
+{
+public:
+  /**
+   * Default constructor.
+   * @param path      Path to resource.
+   * @param use_arena Whether the asset index is allocated from an arena.
+   */
+  resource_snapshot(std::string path, bool use_arena);
+
+  /**
+   * Reads the data of the asset. May be called from multiple threads at once.
+   * The embedded data are read from the file of the snapshot one reader at a time
+   * and decompressed concurrently.
+   * @param asset Asset of the snapshot.
+   * @return Data of the asset.
+   * @throws std::runtime_error
+   */
+  std::vector<std::byte> read_data(const asset& asset) const;
+
+private:
+  /**
+   * Serializes the reads from the resource stream.
+   */
+  mutable std::mutex stream_mutex;
+};
+
+/**
+ * Resource which is reloaded when its file is replaced.
+ *
+ * Every reload reads the resource into a new snapshot, which is then published atomically.
+ * Readers take a snapshot and keep using it until they release it, so they never block
+ * on a reload nor see a partially read index. A snapshot is destroyed once the last reader
+ * releases it. The snapshot keeps its file open, so replacing the file by renaming a new one
+ * over it doesn't affect the readers of the snapshot.
+ *
+ * Snapshots are shared between threads and must only be accessed through const members.
+ * The asset data which weren't read into the snapshot are read through
+ * resource_snapshot::read_data().
+ */
+class reloadable_resource
+{
+public:
+  /**
+   * Reads the resource and starts watching its file.
+   * @param path    Path to resource.
+   * @param options Reload options.
+   * @throws std::runtime_error
+   */
+  explicit reloadable_resource(std::filesystem::path path, reload_options options = {});
+
+  /**
+   * Stops watching the resource file. Snapshots held by readers remain valid.
+   */
+  ~reloadable_resource();
+
+  reloadable_resource(const reloadable_resource&) = delete;
+  reloadable_resource& operator=(const reloadable_resource&) = delete;
+
+  /**
+   * @return Current snapshot. Never blocks.
+   */
+  std::shared_ptr<const resource_snapshot> snapshot() const noexcept;
+
+  /**
+   * Reads the resource into a new snapshot and publishes it, regardless of whether the
+   * file has changed.
+   * @throws std::runtime_error
+   */
+  void reload();
+
+  /**
+   * @return Number of published snapshots, including the initial one.
+   */
+  uint64_t generation() const noexcept;
+
+private:
+  /**
+   * Represents the state of the resource file used to detect changes.
+   */
+  struct file_stamp
+  {
+    std::filesystem::file_time_type write_time{};
+    uintmax_t size{};
+
+    bool operator==(const file_stamp&) const = default;
+  };
+
+  /**
+   * @return Current state of the resource file. Empty if the file doesn't exist.
+   */
+  file_stamp read_file_stamp() const;
+
+  /**
+   * Reads the resource into a new snapshot and publishes it.
+   * @param stamp State of the file before the read.
+   * @throws std::runtime_error
+   */
+  void publish(const file_stamp& stamp);
+
+  /**
+   * Checks the resource file for changes and reloads it until stopped.
+   * @param stop_token Stop token.
+   */
+  void watch(const std::stop_token& stop_token);
+
+  /**
+   * Path to resource.
+   */
+  std::filesystem::path path;
+
+  /**
+   * Reload options.
+   */
+  reload_options options;
+
+  /**
+   * Current snapshot.
+   */
+  std::atomic<std::shared_ptr<const resource_snapshot>> current;
+
+  /**
+   * Number of published snapshots.
+   */
+  std::atomic<uint64_t> published{};
+
+  /**
+   * Serializes the reloads. Readers never take it.
+   */
+  std::mutex reload_mutex;
+
+  /**
+   * State of the resource file the current snapshot was read from.
+   */
+  file_stamp stamp;
+
+  /**
+   * Mutex and condition variable the watcher waits on between checks.
+   */
+  std::mutex watch_mutex;
+  std::condition_variable_any watch_condition;
+
+  /**
+   * Watcher thread.
+   */
+  std::jthread watcher;
+};
+
+} // namespace libpak
+
+#endif // LIBPAK_RELOADABLE_HPP
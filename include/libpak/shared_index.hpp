@@ -0,0 +1,180 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#ifndef LIBPAK_SHARED_INDEX_HPP
+#define LIBPAK_SHARED_INDEX_HPP
+
+#include "libpak.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace libpak
+{
+
+#pragma pack(push, 1)
+
+/**
+ * Represents the header of a shared index segment. The segment contains only offsets
+ * relative to its start, so it can be mapped at any address.
+ *
+ * The segment is laid out as follows:
+ * - shared_index_header
+ * - asset headers of the indexed assets, in the order of their header offset
+ * - slots of the indexed assets, in the order of their path hash
+ */
+struct shared_index_header
+{
+  uint32_t magic{0x494B4150}; // ASCII: PAKI
+  uint32_t version{1};
+
+  //! Size of the segment.
+  uint64_t segment_size{};
+
+  //! Size of the resource file the index was built from.
+  uint64_t resource_size{};
+  //! Last write time of the resource file the index was built from.
+  int64_t resource_write_time{};
+
+  libpak::pak_header pak_header{};
+  libpak::content_header content_header{};
+
+  //! Number of indexed assets.
+  uint32_t assets_count{};
+  //! Offset of the asset headers in the segment.
+  uint64_t headers_offset{};
+  //! Offset of the slots in the segment.
+  uint64_t slots_offset{};
+
+  //! Set once the segment is completely written.
+  uint32_t ready{};
+};
+
+/**
+ * Represents a slot of a shared index, used to look an asset up by its path.
+ */
+struct shared_index_slot
+{
+  //! Hash of the asset path.
+  uint64_t path_hash{};
+  //! Index of the asset header.
+  uint32_t header_index{};
+};
+
+#pragma pack(pop)
+
+/**
+ * Read-only asset index placed in a named shared memory segment.
+ *
+ * A process which has read a resource publishes its index, and other processes attach to
+ * the index instead of reading the resource themselves. Attaching only maps the segment,
+ * no headers are parsed and no memory is allocated per asset. The headers found in the
+ * index can be used to read the asset data from a resource which was only opened.
+ *
+ * On POSIX the segment persists until it is removed, even if the publisher exits.
+ * On Windows the segment exists as long as any process maps it.
+ */
+class shared_index
+{
+public:
+  /**
+   * Publishes the index of the resource. On POSIX an existing segment with the same name
+   * is replaced, processes attached to it keep their mapping. On Windows the publish fails
+   * while a segment with the same name is mapped by any process.
+   * @param resource Resource. Must be read.
+   * @param name     Name of the segment. Should start with a slash to be portable.
+   * @return Index mapped by the publisher.
+   * @throws std::runtime_error
+   */
+  static shared_index publish(const resource& resource, const std::string& name);
+
+  /**
+   * Attaches to a published index. The layout of the segment and the slots are validated,
+   * so that lookups never read outside of it.
+   * @param name          Name of the segment.
+   * @param resource_path Path to the resource the index must be built from.
+   * The index is rejected if the resource has changed since. Not checked if empty.
+   * @return Index.
+   * @throws std::runtime_error
+   */
+  static shared_index attach(const std::string& name, const std::filesystem::path& resource_path = {});
+
+  /**
+   * Removes the segment. Processes attached to it keep their mapping.
+   * @param name Name of the segment.
+   */
+  static void remove(const std::string& name) noexcept;
+
+  shared_index(shared_index&& other) noexcept;
+  shared_index& operator=(shared_index&& other) noexcept;
+  shared_index(const shared_index&) = delete;
+  shared_index& operator=(const shared_index&) = delete;
+
+  /**
+   * Unmaps the segment.
+   */
+  ~shared_index();
+
+  /**
+   * Looks an asset up by its path.
+   * @param path Asset path.
+   * @return Asset header, or nullptr if the asset isn't indexed.
+   */
+  const asset_header* find(std::u16string_view path) const noexcept;
+
+  /**
+   * @return Asset headers, in the order of their header offset.
+   */
+  std::span<const asset_header> headers() const noexcept;
+
+  /**
+   * @return Header of the segment.
+   */
+  const shared_index_header& header() const noexcept;
+
+private:
+  shared_index() = default;
+
+  /**
+   * Unmaps the segment.
+   */
+  void unmap() noexcept;
+
+  /**
+   * Start of the mapped segment.
+   */
+  const std::byte* segment{nullptr};
+
+  /**
+   * Size of the mapped segment.
+   */
+  size_t segment_size{};
+
+  /**
+   * Handle of the mapping, used only on Windows.
+   */
+  void* mapping{nullptr};
+};
+
+} // namespace libpak
+
+#endif // LIBPAK_SHARED_INDEX_HPP
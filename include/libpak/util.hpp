@@ -20,6 +20,7 @@
 #ifndef LIBPAK_UTIL_HPP
 #define LIBPAK_UTIL_HPP
 
+#include <filesystem>
 #include <functional>
 
 namespace libpak::util
@@ -41,6 +42,22 @@ struct defer
   ~defer() { func(); }
 };
 
+/**
+ * Flushes the file contents to the storage device.
+ * @param path Path to the file.
+ * @throws std::runtime_error
+ */
+void sync_file(const std::filesystem::path& path);
+
+/**
+ * Flushes the directory entries to the storage device, so that
+ * a file created or renamed in the directory is persisted.
+ * Does nothing on platforms which don't support it.
+ * @param path Path to the directory.
+ * @throws std::runtime_error
+ */
+void sync_directory(const std::filesystem::path& path);
+
 } // namespace libpak::util
 
 #endif // LIBPAK_UTIL_HPP
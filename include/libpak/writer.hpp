@@ -0,0 +1,115 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#ifndef LIBPAK_WRITER_HPP
+#define LIBPAK_WRITER_HPP
+
+#include "definitions.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+namespace libpak
+{
+
+/**
+ * Writes a resource in a single sequential pass. The embedded data are streamed
+ * from the data sector, while the header table is built in memory and written
+ * as one contiguous block on commit.
+ *
+ * The resource is staged in a temporary file next to the target, which is synced
+ * and then atomically renamed over the target on commit. The staging file has a unique
+ * name, so that writers to the same target don't interfere until they commit, and the
+ * last commit wins. The staging file is removed if the writer is destroyed without
+ * being committed.
+ */
+class writer
+{
+public:
+  /**
+   * Constructs the writer and creates the staging file.
+   * @param path         Path to the target.
+   * @param assets_count Number of assets which will be written.
+   * @throws std::runtime_error
+   */
+  writer(std::filesystem::path path, size_t assets_count);
+
+  writer(const writer&) = delete;
+  writer& operator=(const writer&) = delete;
+
+  /**
+   * Removes the staging file if the writer was not committed.
+   */
+  ~writer();
+
+  /**
+   * Writes the embedded data at the data cursor and updates the embedded data offset
+   * and length of the asset header.
+   * @param header Asset header.
+   * @param data   Embedded data.
+   * @param length Embedded data length.
+   * @throws std::runtime_error
+   */
+  void write_data(asset_header& header, const std::byte* data, uint64_t length);
+
+  /**
+   * Adds the asset header to the header table. Updates its header offset, path length
+   * and path hashes.
+   * @param header Asset header.
+   * @throws std::runtime_error
+   */
+  void add_header(asset_header& header);
+
+  /**
+   * Writes the headers and replaces the target with the staging file.
+   * The asset counts and the file size of the headers are updated.
+   * @param pak_header     PAK header.
+   * @param content_header Content header.
+   * @param data_header    Data header.
+   * @throws std::runtime_error
+   */
+  void commit(pak_header& pak_header, content_header& content_header, const data_header& data_header);
+
+  /**
+   * Updates the path length and the path hashes of the asset header.
+   * @param header Asset header.
+   */
+  static void update_header_hashes(asset_header& header);
+
+  /**
+   * Output stream of the staging file, positioned at the data cursor.
+   */
+  std::shared_ptr<std::ofstream> output;
+
+private:
+  std::filesystem::path target_path;
+  std::filesystem::path staging_path;
+
+  std::vector<char> write_buffer;
+  std::vector<asset_header> header_table;
+
+  size_t assets_count;
+  bool is_committed{false};
+};
+
+} // namespace libpak
+
+#endif // LIBPAK_WRITER_HPP
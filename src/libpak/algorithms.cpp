@@ -19,6 +19,11 @@
 
 #include "libpak/algorithms.hpp"
 
+#include <cctype>
+#include <stdexcept>
+
+#include <zlib.h>
+
 namespace libpak::alg
 {
 
@@ -34,5 +39,75 @@ int32_t alicia_checksum(const char* buffer, uint64_t length)
   return result;
 }
 
+uint32_t capitalized_string_crc32(const std::string_view string)
+{
+  uLong value{0};
+
+  for (char c : string)
+  {
+    c = static_cast<char>(std::toupper(c));
+
+    value = crc32(
+      value,
+      reinterpret_cast<const Bytef*>(&c),
+      sizeof(c));
+  }
+
+  return static_cast<uint32_t>(value);
+}
+
+void compress(const std::byte* source, uint64_t source_length, std::vector<std::byte>& buffer, int level)
+{
+  uLongf compressed_size = compressBound(static_cast<uLong>(source_length));
+  buffer.resize(compressed_size);
+
+  const auto compression_result = compress2(
+    reinterpret_cast<Bytef*>(buffer.data()),
+    &compressed_size,
+    reinterpret_cast<const Bytef*>(source),
+    static_cast<uLong>(source_length),
+    level);
+
+  switch (compression_result)
+  {
+    case Z_BUF_ERROR:
+    case Z_MEM_ERROR:
+      throw std::runtime_error("not enough memory for compressed data");
+    case Z_STREAM_ERROR:
+      throw std::runtime_error("invalid compression level");
+    default:
+      {};
+      break;
+  }
+
+  buffer.resize(compressed_size);
+}
+
+uint64_t decompress(const std::byte* source, uint64_t source_length, std::byte* buffer, uint64_t length)
+{
+  uLongf source_size = static_cast<uLongf>(source_length);
+  uLongf decompressed_size = static_cast<uLongf>(length);
+
+  const auto compression_result = uncompress2(
+    reinterpret_cast<Bytef*>(buffer),
+    &decompressed_size,
+    reinterpret_cast<const Bytef*>(source),
+    &source_size);
+
+  switch (compression_result)
+  {
+    case Z_BUF_ERROR:
+    case Z_MEM_ERROR:
+      throw std::runtime_error("not enough memory for uncompressed data");
+    case Z_DATA_ERROR:
+      throw std::runtime_error("corrupted compressed data");
+    default:
+      {};
+      break;
+  }
+
+  return decompressed_size;
+}
+
 } // namespace libpak::alg
 
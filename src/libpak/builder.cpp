@@ -0,0 +1,440 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#include "libpak/builder.hpp"
+#include "libpak/algorithms.hpp"
+#include "libpak/util.hpp"
+#include "libpak/writer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <zlib.h>
+
+namespace
+{
+
+/**
+ * Represents a file to pack.
+ */
+struct source_file
+{
+  std::filesystem::path path;
+  std::u16string asset_path;
+  uint64_t size{};
+  uint32_t timestamp{};
+};
+
+/**
+ * Represents a file read and compressed, waiting to be written.
+ */
+struct prepared_asset
+{
+  libpak::asset_header header{};
+  std::vector<std::byte> embedded_data;
+  bool is_ready{false};
+};
+
+/**
+ * Walks the directory tree with a pool of workers.
+ * @param root    Root directory.
+ * @param threads Number of workers.
+ * @return Files of the directory tree.
+ */
+std::vector<source_file> walk_directory(const std::filesystem::path& root, const uint32_t threads)
+{
+  std::mutex mutex;
+  std::condition_variable directory_available;
+  std::deque<std::filesystem::path> directories{root};
+  uint32_t busy_workers = 0;
+  std::exception_ptr error;
+
+  std::vector<source_file> files;
+
+  const auto walk = [&]()
+  {
+    while (true)
+    {
+      std::filesystem::path directory;
+      {
+        std::unique_lock lock(mutex);
+        directory_available.wait(
+          lock,
+          [&]()
+          {
+            return error != nullptr || !directories.empty() || busy_workers == 0;
+          });
+        if (error != nullptr || directories.empty())
+          return;
+
+        directory = std::move(directories.front());
+        directories.pop_front();
+        busy_workers++;
+      }
+
+      std::vector<std::filesystem::path> found_directories;
+      std::vector<source_file> found_files;
+      try
+      {
+        for (const auto& entry : std::filesystem::directory_iterator(directory))
+        {
+          if (entry.is_directory())
+          {
+            // Symlinked directories aren't followed, a link loop would be walked forever.
+            if (entry.is_symlink())
+              continue;
+
+            found_directories.emplace_back(entry.path());
+            continue;
+          }
+          if (!entry.is_regular_file())
+            continue;
+
+          const auto timestamp = std::chrono::clock_cast<std::chrono::system_clock>(
+            entry.last_write_time());
+
+          found_files.emplace_back(source_file{
+            .path = entry.path(),
+            .asset_path = entry.path().lexically_relative(root).generic_u16string(),
+            .size = entry.file_size(),
+            .timestamp = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(
+              timestamp.time_since_epoch()).count())});
+        }
+      }
+      catch (...)
+      {
+        std::scoped_lock lock(mutex);
+        if (error == nullptr)
+          error = std::current_exception();
+      }
+
+      {
+        std::scoped_lock lock(mutex);
+        std::ranges::move(found_directories, std::back_inserter(directories));
+        std::ranges::move(found_files, std::back_inserter(files));
+        busy_workers--;
+      }
+      directory_available.notify_all();
+    }
+  };
+
+  {
+    std::vector<std::jthread> workers;
+    for (uint32_t index = 0; index < threads; index++)
+      workers.emplace_back(walk);
+  }
+
+  if (error != nullptr)
+    std::rethrow_exception(error);
+
+  return files;
+}
+
+/**
+ * Encodes the date of the timestamp in the DOS format.
+ * Dates before the DOS epoch are clamped to it.
+ * @param timestamp Unix timestamp, in UTC.
+ * @return DOS date.
+ */
+uint32_t dos_date(const uint32_t timestamp)
+{
+  const std::chrono::sys_seconds time{std::chrono::seconds(timestamp)};
+  const std::chrono::year_month_day date{std::chrono::floor<std::chrono::days>(time)};
+  if (date.year() < std::chrono::year(1980))
+    return (1u << 5) | 1u;
+
+  return (static_cast<uint32_t>(static_cast<int>(date.year()) - 1980) << 9)
+    | (static_cast<uint32_t>(static_cast<unsigned>(date.month())) << 5)
+    | static_cast<uint32_t>(static_cast<unsigned>(date.day()));
+}
+
+/**
+ * Encodes the time of the day of the timestamp in the DOS format.
+ * @param timestamp Unix timestamp, in UTC.
+ * @return DOS time, with a two-second resolution.
+ */
+uint32_t dos_time(const uint32_t timestamp)
+{
+  const std::chrono::sys_seconds time{std::chrono::seconds(timestamp)};
+  const std::chrono::hh_mm_ss day_time{time - std::chrono::floor<std::chrono::days>(time)};
+
+  return (static_cast<uint32_t>(day_time.hours().count()) << 11)
+    | (static_cast<uint32_t>(day_time.minutes().count()) << 5)
+    | static_cast<uint32_t>(day_time.seconds().count() / 2);
+}
+
+/**
+ * @param options Build options.
+ * @param file    File.
+ * @return Compression level of the file.
+ */
+int compression_level(const libpak::build_options& options, const source_file& file)
+{
+  auto extension = file.path.extension().string();
+  std::ranges::transform(
+    extension,
+    extension.begin(),
+    [](const unsigned char c)
+    {
+      return static_cast<char>(std::tolower(c));
+    });
+
+  const auto level = options.compression_levels.find(extension);
+  return level != options.compression_levels.end()
+    ? level->second
+    : options.default_compression_level;
+}
+
+/**
+ * @param buffer Buffer.
+ * @return Alicia checksum of the buffer.
+ */
+uint32_t checksum(const std::vector<std::byte>& buffer)
+{
+  if (buffer.empty())
+    return 0;
+
+  return static_cast<uint32_t>(libpak::alg::alicia_checksum(
+    reinterpret_cast<const char*>(buffer.data()),
+    buffer.size()));
+}
+
+/**
+ * @param buffer Buffer.
+ * @return CRC of the buffer.
+ */
+uint32_t crc(const std::vector<std::byte>& buffer)
+{
+  return static_cast<uint32_t>(crc32(
+    0, // initial crc cycle value
+    reinterpret_cast<const Bytef*>(buffer.data()),
+    static_cast<uInt>(buffer.size())));
+}
+
+/**
+ * Reads and compresses the file.
+ * @param options Build options.
+ * @param file    File.
+ * @param asset   Prepared asset.
+ */
+void prepare_asset(const libpak::build_options& options, const source_file& file, prepared_asset& asset)
+{
+  auto& header = asset.header;
+  if (file.asset_path.size() >= std::size(header.path))
+    throw std::runtime_error("asset path is too long");
+  std::ranges::copy(file.asset_path, header.path);
+
+  std::vector<std::byte> data(file.size);
+  std::ifstream input(file.path, std::ios::binary);
+  input.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+  if (!input.good() && !data.empty())
+    throw std::runtime_error(std::format("failed to read file {}", file.path.string()));
+
+  header.timestamp = file.timestamp;
+  header.date_created = dos_date(file.timestamp);
+  header.time_created = dos_time(file.timestamp);
+  header.are_data_embedded = 1;
+  header.data_decompressed_length = static_cast<uint32_t>(data.size());
+  header.crc_decompressed = crc(data);
+  header.checksum_decompressed = checksum(data);
+
+  const int level = compression_level(options, file);
+  if (level == 0 || data.empty())
+  {
+    // Both embedded CRC and checksums are identical.
+    header.are_data_compressed = 0;
+    header.crc_embedded = header.crc_decompressed;
+    header.checksum_embedded = header.checksum_decompressed;
+    asset.embedded_data = std::move(data);
+    return;
+  }
+
+  header.are_data_compressed = 1;
+  libpak::alg::compress(data.data(), data.size(), asset.embedded_data, level);
+  header.crc_embedded = crc(asset.embedded_data);
+  header.checksum_embedded = checksum(asset.embedded_data);
+}
+
+} // namespace
+
+libpak::build_result libpak::build(const build_options& options)
+{
+  const auto started = std::chrono::steady_clock::now();
+
+  const uint32_t thread_count = options.threads != 0
+    ? options.threads
+    : std::max(1u, std::thread::hardware_concurrency());
+
+  auto files = walk_directory(options.source_directory, thread_count);
+  std::ranges::sort(files, {}, &source_file::asset_path);
+
+  const auto cost = [](const source_file& file)
+  {
+    // the file data and its compressed data
+    return 2 * file.size;
+  };
+
+  std::mutex mutex;
+  std::condition_variable budget_available;
+  std::condition_variable asset_ready;
+  std::exception_ptr error;
+
+  std::vector<prepared_asset> prepared_assets(files.size());
+  size_t next_index = 0;
+  uint64_t in_flight = 0;
+  bool is_stopped = false;
+
+  const auto abort = [&]()
+  {
+    {
+      std::scoped_lock lock(mutex);
+      if (error == nullptr)
+        error = std::current_exception();
+    }
+    budget_available.notify_all();
+    asset_ready.notify_all();
+  };
+
+  // the files are claimed in order, so that the file the writer
+  // waits for always fits in the budget
+  const auto prepare = [&]()
+  {
+    while (true)
+    {
+      size_t index = 0;
+      {
+        std::unique_lock lock(mutex);
+        budget_available.wait(
+          lock,
+          [&]()
+          {
+            return error != nullptr
+              || is_stopped
+              || next_index == files.size()
+              || in_flight == 0
+              || in_flight + cost(files[next_index]) <= options.memory_budget;
+          });
+        if (error != nullptr || is_stopped || next_index == files.size())
+          return;
+
+        index = next_index++;
+        in_flight += cost(files[index]);
+      }
+
+      try
+      {
+        prepared_asset asset;
+        prepare_asset(options, files[index], asset);
+
+        {
+          std::scoped_lock lock(mutex);
+          prepared_assets[index] = std::move(asset);
+          prepared_assets[index].is_ready = true;
+        }
+        asset_ready.notify_all();
+      }
+      catch (...)
+      {
+        abort();
+        return;
+      }
+    }
+  };
+
+  build_result result;
+  result.assets_count = static_cast<uint32_t>(files.size());
+
+  writer writer(options.output_path, files.size());
+
+  {
+    std::vector<std::jthread> workers;
+    util::defer stop_workers(
+      [&]()
+      {
+        {
+          std::scoped_lock lock(mutex);
+          is_stopped = true;
+        }
+        budget_available.notify_all();
+      });
+
+    for (uint32_t index = 0; index < thread_count; index++)
+      workers.emplace_back(prepare);
+
+    // write the prepared assets sequentially
+    for (size_t index = 0; index < files.size(); index++)
+    {
+      prepared_asset asset;
+      {
+        std::unique_lock lock(mutex);
+        asset_ready.wait(
+          lock,
+          [&]()
+          {
+            return error != nullptr || prepared_assets[index].is_ready;
+          });
+        if (error != nullptr)
+          break;
+
+        asset = std::move(prepared_assets[index]);
+      }
+
+      try
+      {
+        writer.write_data(asset.header, asset.embedded_data.data(), asset.embedded_data.size());
+        writer.add_header(asset.header);
+      }
+      catch (...)
+      {
+        abort();
+        break;
+      }
+
+      result.input_bytes += files[index].size;
+      result.embedded_bytes += asset.embedded_data.size();
+
+      {
+        std::scoped_lock lock(mutex);
+        in_flight -= cost(files[index]);
+      }
+      budget_available.notify_all();
+    }
+  }
+
+  if (error != nullptr)
+    std::rethrow_exception(error);
+
+  pak_header pak_header = options.pak_header;
+  content_header content_header = options.content_header;
+  writer.commit(pak_header, content_header, data_header{});
+
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+  if (elapsed.count() > 0)
+    result.throughput = static_cast<double>(result.input_bytes) / elapsed.count();
+
+  return result;
+}
@@ -0,0 +1,538 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#include "libpak/libpak.hpp"
+#include "libpak/util.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <stdexcept>
+
+namespace
+{
+
+//! Size of the buffer used to move the embedded data.
+constexpr uint64_t COMPACTION_BUFFER_SIZE = 4 * 1024 * 1024;
+
+//! Compaction journal magic, ASCII: PAKC
+constexpr uint32_t COMPACTION_JOURNAL_MAGIC = 0x434B4150;
+
+/**
+ * Compaction phases.
+ */
+enum class compaction_phase : uint32_t
+{
+  move_data = 0,
+  write_headers = 1,
+};
+
+#pragma pack(push, 1)
+
+/**
+ * Represents compaction journal header.
+ */
+struct journal_header
+{
+  uint32_t magic{};
+  compaction_phase phase{compaction_phase::move_data};
+
+  uint32_t extent_count{};
+  uint32_t header_count{};
+
+  //! Index of the extent being moved.
+  uint64_t extent_progress{};
+  //! Number of bytes of the extent already moved.
+  uint64_t byte_progress{};
+
+  //! Destination of the chunk stored in the journal scratch area.
+  uint64_t pending_destination{};
+  //! Length of the chunk stored in the journal scratch area.
+  uint64_t pending_length{};
+
+  uint64_t data_end{};
+  uint64_t header_table_end{};
+  uint64_t original_header_table_end{};
+  uint64_t original_size{};
+  uint32_t dropped_assets{};
+
+  libpak::pak_header pak_header{};
+  libpak::content_header content_header{};
+};
+
+/**
+ * Represents a contiguous range of embedded data to move.
+ */
+struct journal_extent
+{
+  uint64_t source{};
+  uint64_t destination{};
+  uint64_t length{};
+};
+
+#pragma pack(pop)
+
+/**
+ * Represents compaction journal.
+ */
+struct journal
+{
+  journal_header header{};
+  std::vector<journal_extent> extents{};
+  std::vector<libpak::asset_header> headers{};
+
+  //! Path to the resource, not stored.
+  std::filesystem::path resource_path;
+  //! Path to the journal, not stored.
+  std::filesystem::path path;
+
+  //! @return Offset of the journal scratch area.
+  [[nodiscard]] uint64_t scratch_offset() const
+  {
+    return sizeof(journal_header)
+      + extents.size() * sizeof(journal_extent)
+      + headers.size() * sizeof(libpak::asset_header);
+  }
+};
+
+void read_at(std::fstream& file, const uint64_t offset, void* buffer, const uint64_t size)
+{
+  file.seekg(static_cast<std::streamoff>(offset));
+  file.read(static_cast<char*>(buffer), static_cast<std::streamsize>(size));
+  if (!file.good())
+    throw std::runtime_error(std::format("failed to read {} bytes at {}", size, offset));
+}
+
+void write_at(std::fstream& file, const uint64_t offset, const void* buffer, const uint64_t size)
+{
+  file.seekp(static_cast<std::streamoff>(offset));
+  file.write(static_cast<const char*>(buffer), static_cast<std::streamsize>(size));
+  if (!file.good())
+    throw std::runtime_error(std::format("failed to write {} bytes at {}", size, offset));
+}
+
+/**
+ * Stores the journal header and syncs the journal. The resource and the journal scratch
+ * area are synced first, so that the header never refers to data which could be lost
+ * on a power failure.
+ * @param file    Journal file.
+ * @param journal Journal.
+ */
+void store_journal_header(std::fstream& file, const journal& journal)
+{
+  file.flush();
+  libpak::util::sync_file(journal.resource_path);
+  libpak::util::sync_file(journal.path);
+
+  write_at(file, 0, &journal.header, sizeof(journal.header));
+  file.flush();
+  libpak::util::sync_file(journal.path);
+}
+
+/**
+ * Stores the whole journal. The magic is written last, so that a journal
+ * interrupted while being stored is never considered valid.
+ * @param file    Journal file.
+ * @param journal Journal.
+ */
+void store_journal(std::fstream& file, journal& journal)
+{
+  journal.header.magic = 0;
+  write_at(file, 0, &journal.header, sizeof(journal.header));
+  file.write(
+    reinterpret_cast<const char*>(journal.extents.data()),
+    static_cast<std::streamsize>(journal.extents.size() * sizeof(journal_extent)));
+  file.write(
+    reinterpret_cast<const char*>(journal.headers.data()),
+    static_cast<std::streamsize>(journal.headers.size() * sizeof(libpak::asset_header)));
+  if (!file.good())
+    throw std::runtime_error("failed to write compaction journal");
+  file.flush();
+
+  journal.header.magic = COMPACTION_JOURNAL_MAGIC;
+  store_journal_header(file, journal);
+}
+
+/**
+ * Loads the journal.
+ * @param file    Journal file.
+ * @param journal Journal.
+ * @return True if the journal is complete, otherwise returns false.
+ */
+bool load_journal(std::fstream& file, journal& journal)
+{
+  file.seekg(0, std::ios::end);
+  const auto size = static_cast<uint64_t>(file.tellg());
+  if (size < sizeof(journal_header))
+    return false;
+
+  read_at(file, 0, &journal.header, sizeof(journal.header));
+  if (journal.header.magic != COMPACTION_JOURNAL_MAGIC)
+    return false;
+
+  journal.extents.resize(journal.header.extent_count);
+  journal.headers.resize(journal.header.header_count);
+  if (size < journal.scratch_offset())
+    return false;
+
+  file.read(
+    reinterpret_cast<char*>(journal.extents.data()),
+    static_cast<std::streamsize>(journal.extents.size() * sizeof(journal_extent)));
+  file.read(
+    reinterpret_cast<char*>(journal.headers.data()),
+    static_cast<std::streamsize>(journal.headers.size() * sizeof(libpak::asset_header)));
+  return file.good();
+}
+
+/**
+ * Plans the compaction of the resource. The header table is read from the resource
+ * itself, so that assets sharing a path are all accounted for.
+ * @param pak     Resource file.
+ * @param journal Journal to fill.
+ * @return True if there is anything to compact, otherwise returns false.
+ */
+bool plan_compaction(std::fstream& pak, journal& journal)
+{
+  auto& state = journal.header;
+  state.original_size = static_cast<uint64_t>(pak.seekg(0, std::ios::end).tellg());
+
+  read_at(pak, 0, &state.pak_header, sizeof(state.pak_header));
+  read_at(pak, libpak::PAK_CONTENT_SECTOR, &state.content_header, sizeof(state.content_header));
+
+  std::vector<libpak::asset_header> headers(state.content_header.assets_count);
+  pak.read(
+    reinterpret_cast<char*>(headers.data()),
+    static_cast<std::streamsize>(headers.size() * sizeof(libpak::asset_header)));
+  if (!pak.good())
+    throw std::runtime_error("failed to read asset headers");
+
+  state.original_header_table_end = libpak::PAK_CONTENT_SECTOR
+    + sizeof(libpak::content_header)
+    + headers.size() * sizeof(libpak::asset_header);
+
+  // keep only the live assets
+  std::vector<libpak::asset_header*> live;
+  for (auto& header : headers)
+  {
+    if (header.is_asset_deleted)
+    {
+      state.dropped_assets++;
+      continue;
+    }
+    live.emplace_back(&header);
+  }
+
+  // order the live assets by their embedded data
+  std::ranges::stable_sort(live, {}, &libpak::asset_header::embedded_data_offset);
+
+  // lay the live headers out contiguously, keeping their original order
+  uint64_t header_offset = libpak::PAK_CONTENT_SECTOR + sizeof(libpak::content_header);
+  for (auto& header : headers)
+  {
+    if (header.is_asset_deleted)
+      continue;
+
+    header.header_offset = static_cast<uint32_t>(header_offset);
+    header_offset += sizeof(libpak::asset_header);
+  }
+  state.header_table_end = header_offset;
+
+  // the data follow the compacted header table, which may run past the data sector,
+  // and are never moved up
+  const uint64_t table_end = state.header_table_end + sizeof(libpak::data_header);
+  uint64_t cursor = std::max<uint64_t>(libpak::PAK_DATA_SECTOR, table_end);
+  for (const auto* header : live)
+  {
+    if (header->are_data_embedded && header->embedded_data_length != 0)
+    {
+      cursor = std::min<uint64_t>(cursor, header->embedded_data_offset);
+      break;
+    }
+  }
+
+  if (cursor < table_end)
+    throw std::runtime_error("embedded data overlap the header table");
+
+  // merge the embedded data of live assets into extents and assign their destinations,
+  // assets sharing their embedded data stay sharing it
+  for (auto* header : live)
+  {
+    if (!header->are_data_embedded || header->embedded_data_length == 0)
+      continue;
+
+    const uint64_t begin = header->embedded_data_offset;
+    const uint64_t end = begin + header->embedded_data_length;
+
+    if (journal.extents.empty() || begin >= journal.extents.back().source + journal.extents.back().length)
+    {
+      journal.extents.emplace_back(journal_extent{
+        .source = begin,
+        .destination = cursor,
+        .length = end - begin});
+    }
+    else
+    {
+      auto& extent = journal.extents.back();
+      extent.length = std::max(extent.length, end - extent.source);
+    }
+
+    const auto& extent = journal.extents.back();
+    cursor = extent.destination + extent.length;
+    header->embedded_data_offset = static_cast<uint32_t>(
+      extent.destination + (begin - extent.source));
+  }
+  state.data_end = cursor;
+
+  for (const auto& header : headers)
+  {
+    if (!header.is_asset_deleted)
+      journal.headers.emplace_back(header);
+  }
+
+  state.extent_count = static_cast<uint32_t>(journal.extents.size());
+  state.header_count = static_cast<uint32_t>(journal.headers.size());
+
+  // update the headers
+  state.content_header.assets_count = state.header_count;
+  state.pak_header.assets_count = state.header_count;
+  state.pak_header.used_assets_count = state.header_count;
+  state.pak_header.deleted_assets_count = 0;
+  state.pak_header.file_size = static_cast<uint32_t>(
+    state.header_table_end + sizeof(libpak::data_header));
+
+  const bool moves_data = std::ranges::any_of(
+    journal.extents,
+    [](const journal_extent& extent)
+    {
+      return extent.source != extent.destination;
+    });
+
+  return moves_data || state.dropped_assets != 0 || state.original_size > state.data_end;
+}
+
+/**
+ * Moves the embedded data towards the start of the data sector.
+ * @param pak          Resource file.
+ * @param journal_file Journal file.
+ * @param journal      Journal.
+ */
+void move_data(std::fstream& pak, std::fstream& journal_file, journal& journal)
+{
+  auto& state = journal.header;
+  std::vector<char> buffer(COMPACTION_BUFFER_SIZE);
+
+  // finish the chunk which was interrupted while being written over its own source
+  if (state.pending_length != 0)
+  {
+    read_at(journal_file, journal.scratch_offset(), buffer.data(), state.pending_length);
+    write_at(pak, state.pending_destination, buffer.data(), state.pending_length);
+    pak.flush();
+
+    state.byte_progress += state.pending_length;
+    state.pending_length = 0;
+    store_journal_header(journal_file, journal);
+  }
+
+  for (; state.extent_progress < journal.extents.size(); state.extent_progress++)
+  {
+    const auto& extent = journal.extents[state.extent_progress];
+    if (extent.source == extent.destination)
+    {
+      state.byte_progress = 0;
+      continue;
+    }
+
+    // the data are only ever moved down, so the unmoved part of the source
+    // is never overwritten by the destination
+    const uint64_t distance = extent.source - extent.destination;
+
+    while (state.byte_progress < extent.length)
+    {
+      const uint64_t size = std::min(
+        COMPACTION_BUFFER_SIZE,
+        extent.length - state.byte_progress);
+      const uint64_t destination = extent.destination + state.byte_progress;
+
+      read_at(pak, extent.source + state.byte_progress, buffer.data(), size);
+
+      // the chunk overlaps its own source, stage it in the journal first
+      // so that it can be rewritten if interrupted
+      if (size > distance)
+      {
+        write_at(journal_file, journal.scratch_offset(), buffer.data(), size);
+        state.pending_destination = destination;
+        state.pending_length = size;
+        store_journal_header(journal_file, journal);
+      }
+
+      write_at(pak, destination, buffer.data(), size);
+      pak.flush();
+
+      state.byte_progress += size;
+      state.pending_length = 0;
+      store_journal_header(journal_file, journal);
+    }
+
+    state.byte_progress = 0;
+  }
+}
+
+/**
+ * Writes the compacted header table and the resource headers.
+ * @param pak     Resource file.
+ * @param journal Journal.
+ */
+void write_headers(std::fstream& pak, const journal& journal)
+{
+  const auto& state = journal.header;
+
+  write_at(
+    pak,
+    libpak::PAK_CONTENT_SECTOR,
+    &state.content_header,
+    sizeof(state.content_header));
+  pak.write(
+    reinterpret_cast<const char*>(journal.headers.data()),
+    static_cast<std::streamsize>(journal.headers.size() * sizeof(libpak::asset_header)));
+  if (!pak.good())
+    throw std::runtime_error("failed to write asset headers");
+
+  const libpak::data_header data_header;
+  write_at(pak, state.header_table_end, &data_header, sizeof(data_header));
+
+  // clear the stale headers left behind the compacted header table,
+  // up to the moved data
+  const uint64_t data_begin = journal.extents.empty()
+    ? state.data_end
+    : journal.extents.front().destination;
+  const uint64_t stale_begin = state.header_table_end + sizeof(data_header);
+  const uint64_t stale_end = std::min(
+    state.original_header_table_end + sizeof(data_header),
+    data_begin);
+  if (stale_end > stale_begin)
+  {
+    const std::vector<char> zeroes(stale_end - stale_begin);
+    write_at(pak, stale_begin, zeroes.data(), zeroes.size());
+  }
+
+  write_at(pak, 0, &state.pak_header, sizeof(state.pak_header));
+  pak.flush();
+}
+
+} // namespace
+
+libpak::compaction_result libpak::resource::compact()
+{
+  const std::string journal_path = this->resource_path + ".compact";
+
+  // release the resource streams, they are reopened once the compaction finishes
+  this->resource_stream.reset();
+  this->input_stream.reset();
+
+  util::defer reopen_streams(
+    [this]()
+    {
+      this->input_stream = std::make_shared<std::ifstream>(
+        this->resource_path, std::ios::binary);
+      this->resource_stream = std::make_shared<stream>(
+        this->input_stream, this->output_stream);
+    });
+
+  std::fstream pak(this->resource_path, std::ios::binary | std::ios::in | std::ios::out);
+  if (!pak.is_open())
+    throw std::runtime_error("failed to open resource for compaction");
+
+  compaction_result result;
+  journal journal{
+    .resource_path = this->resource_path,
+    .path = journal_path};
+  std::fstream journal_file;
+
+  if (std::filesystem::exists(journal_path))
+  {
+    journal_file.open(journal_path, std::ios::binary | std::ios::in | std::ios::out);
+    result.resumed = journal_file.is_open() && load_journal(journal_file, journal);
+
+    // the journal was interrupted while being stored, nothing was moved yet
+    if (!result.resumed)
+    {
+      journal_file.close();
+      journal = {
+        .resource_path = this->resource_path,
+        .path = journal_path};
+    }
+  }
+
+  if (!result.resumed)
+  {
+    if (!plan_compaction(pak, journal))
+      return result;
+
+    journal_file.open(
+      journal_path,
+      std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+    if (!journal_file.is_open())
+      throw std::runtime_error("failed to create compaction journal");
+    store_journal(journal_file, journal);
+    libpak::util::sync_directory(std::filesystem::path(journal_path).parent_path());
+  }
+
+  auto& state = journal.header;
+  if (state.phase == compaction_phase::move_data)
+  {
+    move_data(pak, journal_file, journal);
+
+    state.phase = compaction_phase::write_headers;
+    store_journal_header(journal_file, journal);
+  }
+
+  write_headers(pak, journal);
+  pak.close();
+
+  const uint64_t compacted_size = std::max(
+    state.data_end,
+    state.header_table_end + sizeof(libpak::data_header));
+  std::filesystem::resize_file(this->resource_path, compacted_size);
+  libpak::util::sync_file(this->resource_path);
+
+  journal_file.close();
+  std::filesystem::remove(journal_path);
+
+  result.reclaimed_bytes = state.original_size - std::min(state.original_size, compacted_size);
+  result.dropped_assets = state.dropped_assets;
+
+  // update the indexed assets
+  this->pak_header = state.pak_header;
+  this->content_header = state.content_header;
+
+  std::erase_if(
+    this->assets,
+    [](const auto& entry)
+    {
+      return entry.second.header.is_asset_deleted != 0;
+    });
+  for (const auto& header : journal.headers)
+  {
+    const auto asset = this->assets.find(header.path);
+    if (asset != this->assets.end())
+      asset->second.header = header;
+  }
+
+  return result;
+}
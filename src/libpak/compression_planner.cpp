@@ -0,0 +1,225 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#include "libpak/compression_planner.hpp"
+#include "libpak/algorithms.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <queue>
+
+namespace
+{
+
+//! Compression levels the planner chooses from, besides storing the data.
+constexpr std::array<int, 3> CANDIDATE_LEVELS{1, 6, 9};
+
+//! Number of planning steps, the first one stores the data.
+constexpr size_t PLAN_STEPS = CANDIDATE_LEVELS.size() + 1;
+
+//! Size of a slice of the data sampled for compressibility.
+constexpr size_t SAMPLE_SLICE_SIZE = 16 * 1024;
+
+//! Number of slices sampled from the data of an asset.
+constexpr size_t SAMPLE_SLICES = 4;
+
+/**
+ * Represents the estimate of an asset's compression.
+ */
+struct asset_estimate
+{
+  //! Estimated embedded size at each step.
+  std::array<uint64_t, PLAN_STEPS> sizes{};
+  //! Current step.
+  size_t step{0};
+};
+
+/**
+ * Represents a step of an asset to the next compression level.
+ */
+struct plan_upgrade
+{
+  //! Embedded bytes saved per second spent.
+  double efficiency{};
+  //! Index of the asset.
+  size_t asset_index{};
+
+  bool operator<(const plan_upgrade& other) const noexcept { return efficiency < other.efficiency; }
+};
+
+/**
+ * Copies evenly spaced slices of the data to the sample.
+ * @param data   Data.
+ * @param sample Sample.
+ */
+void sample_data(const std::vector<std::byte>& data, std::vector<std::byte>& sample)
+{
+  // small data are sampled whole
+  if (data.size() <= SAMPLE_SLICE_SIZE * SAMPLE_SLICES)
+  {
+    sample.assign(data.begin(), data.end());
+    return;
+  }
+
+  sample.resize(SAMPLE_SLICE_SIZE * SAMPLE_SLICES);
+  const size_t stride = (data.size() - SAMPLE_SLICE_SIZE) / (SAMPLE_SLICES - 1);
+  for (size_t slice = 0; slice < SAMPLE_SLICES; slice++)
+  {
+    std::memcpy(
+      sample.data() + slice * SAMPLE_SLICE_SIZE,
+      data.data() + slice * stride,
+      SAMPLE_SLICE_SIZE);
+  }
+}
+
+} // namespace
+
+libpak::compression_plan libpak::plan_compression(
+  const std::span<const asset* const> assets,
+  const compression_goal& goal)
+{
+  compression_plan plan;
+  plan.levels.assign(assets.size(), STORED_COMPRESSION_LEVEL);
+
+  const auto is_compressed = [](const asset& asset)
+  {
+    return asset.header.are_data_embedded
+      && (asset.header.are_data_compressed || asset.is_compression_skipped)
+      && !asset.data.buffer.empty();
+  };
+
+  if (!goal.is_set())
+  {
+    for (size_t index = 0; index < assets.size(); index++)
+    {
+      if (is_compressed(*assets[index]))
+        plan.levels[index] = DEFAULT_COMPRESSION_LEVEL;
+    }
+    return plan;
+  }
+
+  const auto sampling_start = std::chrono::steady_clock::now();
+
+  std::vector<asset_estimate> estimates(assets.size());
+  // time spent compressing the samples at each step, and the size of the samples
+  std::array<std::chrono::nanoseconds, PLAN_STEPS> sample_times{};
+  uint64_t sample_bytes = 0;
+
+  std::vector<std::byte> sample;
+  std::vector<std::byte> compressed_sample;
+  for (size_t index = 0; index < assets.size(); index++)
+  {
+    const auto& asset = *assets[index];
+    auto& estimate = estimates[index];
+
+    const uint64_t size = asset.header.are_data_embedded ? asset.data.buffer.size() : 0;
+    estimate.sizes.fill(size);
+    if (!is_compressed(asset))
+      continue;
+
+    sample_data(asset.data.buffer, sample);
+    sample_bytes += sample.size();
+
+    for (size_t step = 1; step < PLAN_STEPS; step++)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      alg::compress(sample.data(), sample.size(), compressed_sample, CANDIDATE_LEVELS[step - 1]);
+      sample_times[step] += std::chrono::steady_clock::now() - start;
+
+      const double ratio = static_cast<double>(compressed_sample.size())
+        / static_cast<double>(sample.size());
+      estimate.sizes[step] = static_cast<uint64_t>(static_cast<double>(size) * ratio);
+    }
+  }
+
+  // the compression time of a step is proportional to the size of the data
+  const auto estimate_time = [&](const asset& asset, const size_t step)
+  {
+    if (step == 0 || sample_bytes == 0)
+      return std::chrono::nanoseconds{0};
+    return std::chrono::nanoseconds(static_cast<int64_t>(
+      static_cast<double>(sample_times[step].count())
+      * static_cast<double>(asset.data.buffer.size())
+      / static_cast<double>(sample_bytes)));
+  };
+
+  const auto sampling_time = std::chrono::steady_clock::now() - sampling_start;
+  const auto time_budget = std::max(
+    std::chrono::nanoseconds{0},
+    std::chrono::duration_cast<std::chrono::nanoseconds>(goal.time_budget - sampling_time));
+
+  std::priority_queue<plan_upgrade> upgrades;
+  const auto queue_upgrade = [&](const size_t index)
+  {
+    const auto& estimate = estimates[index];
+    if (estimate.step + 1 >= PLAN_STEPS)
+      return;
+
+    const auto saved = static_cast<double>(estimate.sizes[estimate.step])
+      - static_cast<double>(estimate.sizes[estimate.step + 1]);
+    // the data don't compress any better at the next level
+    if (saved <= 0)
+      return;
+
+    const auto spent = estimate_time(*assets[index], estimate.step + 1)
+      - estimate_time(*assets[index], estimate.step);
+    upgrades.push({
+      .efficiency = saved / static_cast<double>(std::max<int64_t>(spent.count(), 1)),
+      .asset_index = index});
+  };
+
+  // start with every asset stored
+  for (size_t index = 0; index < assets.size(); index++)
+  {
+    plan.predicted_size += estimates[index].sizes[0];
+    if (is_compressed(*assets[index]))
+      queue_upgrade(index);
+  }
+
+  while (!upgrades.empty())
+  {
+    if (goal.size_target > 0 && plan.predicted_size <= goal.size_target)
+      break;
+
+    const auto upgrade = upgrades.top();
+    upgrades.pop();
+
+    auto& estimate = estimates[upgrade.asset_index];
+    const auto& asset = *assets[upgrade.asset_index];
+    const auto spent = estimate_time(asset, estimate.step + 1) - estimate_time(asset, estimate.step);
+
+    // the asset stays at its level, cheaper upgrades of other assets may still fit
+    if (goal.time_budget.count() > 0 && plan.predicted_time + spent > time_budget)
+      continue;
+
+    plan.predicted_size -= estimate.sizes[estimate.step] - estimate.sizes[estimate.step + 1];
+    plan.predicted_time += spent;
+    estimate.step++;
+    queue_upgrade(upgrade.asset_index);
+  }
+
+  for (size_t index = 0; index < assets.size(); index++)
+  {
+    const auto step = estimates[index].step;
+    plan.levels[index] = step == 0 ? STORED_COMPRESSION_LEVEL : CANDIDATE_LEVELS[step - 1];
+  }
+
+  return plan;
+}
@@ -0,0 +1,351 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#include "libpak/extract.hpp"
+#include "libpak/algorithms.hpp"
+#include "libpak/util.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <format>
+#include <mutex>
+#include <ranges>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+
+/**
+ * Represents an asset read from the resource and waiting to be extracted.
+ */
+struct extract_job
+{
+  const libpak::asset* asset{};
+  std::vector<std::byte> embedded_data;
+  //! Number of in-flight bytes held by the job.
+  uint64_t cost{};
+};
+
+/**
+ * Represents the state shared between the reader and the workers.
+ */
+class extract_state
+{
+public:
+  extract_state(const libpak::extract_options& options, const uint64_t total_bytes, const uint32_t total_assets)
+    : options(options)
+    , started(std::chrono::steady_clock::now())
+  {
+    progress.total_bytes = total_bytes;
+    progress.total_assets = total_assets;
+  }
+
+  /**
+   * Waits until the budget allows the cost to be in flight.
+   * @param cost Cost.
+   * @return False if the extraction was aborted, otherwise returns true.
+   */
+  bool acquire(const uint64_t cost)
+  {
+    std::unique_lock lock(mutex);
+    budget_available.wait(
+      lock,
+      [&]()
+      {
+        return error != nullptr || in_flight == 0 || in_flight + cost <= options.memory_budget;
+      });
+    if (error != nullptr)
+      return false;
+
+    in_flight += cost;
+    return true;
+  }
+
+  /**
+   * Queues the job for the workers.
+   * @param job Job.
+   */
+  void push(extract_job&& job)
+  {
+    {
+      std::scoped_lock lock(mutex);
+      jobs.emplace_back(std::move(job));
+    }
+    job_available.notify_one();
+  }
+
+  /**
+   * Waits for a job.
+   * @param job Job.
+   * @return False if there are no more jobs, otherwise returns true.
+   */
+  bool pop(extract_job& job)
+  {
+    std::unique_lock lock(mutex);
+    job_available.wait(
+      lock,
+      [&]()
+      {
+        return error != nullptr || finished || !jobs.empty();
+      });
+    if (error != nullptr || jobs.empty())
+      return false;
+
+    job = std::move(jobs.front());
+    jobs.pop_front();
+    return true;
+  }
+
+  /**
+   * Releases the job's budget and reports the progress.
+   * @param job Job.
+   */
+  void complete(const extract_job& job)
+  {
+    libpak::extract_progress snapshot;
+    {
+      std::scoped_lock lock(mutex);
+      in_flight -= job.cost;
+
+      progress.extracted_assets++;
+      progress.extracted_bytes += job.asset->header.embedded_data_length;
+
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+      if (elapsed.count() > 0)
+        progress.throughput = static_cast<double>(progress.extracted_bytes) / elapsed.count();
+      snapshot = progress;
+    }
+    budget_available.notify_one();
+
+    if (options.progress)
+    {
+      std::scoped_lock lock(progress_mutex);
+      options.progress(snapshot);
+    }
+  }
+
+  /**
+   * Aborts the extraction with the current exception.
+   */
+  void abort()
+  {
+    {
+      std::scoped_lock lock(mutex);
+      if (error == nullptr)
+        error = std::current_exception();
+    }
+    budget_available.notify_all();
+    job_available.notify_all();
+  }
+
+  /**
+   * Signals that there are no more jobs.
+   */
+  void finish()
+  {
+    {
+      std::scoped_lock lock(mutex);
+      finished = true;
+    }
+    job_available.notify_all();
+  }
+
+  /**
+   * Rethrows the error which aborted the extraction.
+   */
+  void rethrow()
+  {
+    if (error != nullptr)
+      std::rethrow_exception(error);
+  }
+
+  const libpak::extract_options& options;
+  libpak::extract_progress progress;
+
+private:
+  std::chrono::steady_clock::time_point started;
+
+  std::mutex mutex;
+  std::mutex progress_mutex;
+  std::condition_variable budget_available;
+  std::condition_variable job_available;
+
+  std::deque<extract_job> jobs;
+  uint64_t in_flight{};
+  bool finished{};
+  std::exception_ptr error;
+};
+
+/**
+ * Resolves the output path of the asset. Paths escaping the output directory are rejected.
+ * @param output_directory Output directory.
+ * @param asset            Asset.
+ * @return Output path.
+ */
+std::filesystem::path resolve_output_path(
+  const std::filesystem::path& output_directory,
+  const libpak::asset& asset)
+{
+  auto asset_path = asset.path();
+  std::ranges::replace(asset_path, u'\\', u'/');
+
+  const auto relative_path = std::filesystem::path(asset_path).lexically_normal();
+  if (relative_path.empty()
+    || relative_path.has_root_path()
+    || *relative_path.begin() == "..")
+    throw std::runtime_error("asset path escapes the output directory");
+
+  return output_directory / relative_path;
+}
+
+/**
+ * Decompresses and writes the asset to its file.
+ * @param options Extraction options.
+ * @param job     Job.
+ */
+void extract_asset(const libpak::extract_options& options, extract_job& job)
+{
+  const auto& header = job.asset->header;
+
+  const std::byte* data = job.embedded_data.data();
+  uint64_t data_length = job.embedded_data.size();
+
+  std::vector<std::byte> decompressed_data;
+  if (header.are_data_compressed && !job.embedded_data.empty())
+  {
+    libpak::alg::decompress_embedded_data(
+      job.embedded_data.data(),
+      job.embedded_data.size(),
+      header.data_decompressed_length,
+      decompressed_data);
+    data = decompressed_data.data();
+    data_length = decompressed_data.size();
+  }
+
+  const auto output_path = resolve_output_path(options.output_directory, *job.asset);
+
+  std::error_code error;
+  std::filesystem::create_directories(output_path.parent_path(), error);
+  if (error)
+    throw std::runtime_error(std::format("failed to create directory: {}", error.message()));
+
+  std::ofstream output(output_path, std::ios::binary | std::ios::trunc);
+  output.write(
+    reinterpret_cast<const char*>(data),
+    static_cast<std::streamsize>(data_length));
+  if (!output.good())
+    throw std::runtime_error("failed to write extracted asset");
+}
+
+} // namespace
+
+libpak::extract_progress libpak::extract(resource& resource, const extract_options& options)
+{
+  // select the assets and order them by their embedded data
+  std::vector<const asset*> assets;
+  uint64_t total_bytes = 0;
+  for (const auto& asset : resource.assets | std::views::values)
+  {
+    if (!asset.header.are_data_embedded)
+      continue;
+    if (options.filter && !options.filter(asset))
+      continue;
+
+    assets.emplace_back(&asset);
+    total_bytes += asset.header.embedded_data_length;
+  }
+
+  std::ranges::sort(
+    assets,
+    [](const asset* lhs, const asset* rhs)
+    {
+      return lhs->header.embedded_data_offset < rhs->header.embedded_data_offset;
+    });
+
+  extract_state state(options, total_bytes, static_cast<uint32_t>(assets.size()));
+
+  const uint32_t thread_count = options.threads != 0
+    ? options.threads
+    : std::max(1u, std::thread::hardware_concurrency());
+
+  std::vector<std::jthread> workers;
+  util::defer finish_workers(
+    [&state]()
+    {
+      state.finish();
+    });
+
+  for (uint32_t index = 0; index < thread_count; index++)
+  {
+    workers.emplace_back(
+      [&state]()
+      {
+        extract_job job;
+        while (state.pop(job))
+        {
+          try
+          {
+            extract_asset(state.options, job);
+            state.complete(job);
+          }
+          catch (...)
+          {
+            state.abort();
+          }
+        }
+      });
+  }
+
+  // read the embedded data sequentially
+  for (const auto* asset : assets)
+  {
+    const auto& header = asset->header;
+
+    extract_job job;
+    job.asset = asset;
+    job.cost = header.embedded_data_length;
+    if (header.are_data_compressed)
+      job.cost += std::max(header.embedded_data_length, header.data_decompressed_length);
+
+    if (!state.acquire(job.cost))
+      break;
+
+    try
+    {
+      resource.read_asset_embedded_data(*asset, job.embedded_data);
+    }
+    catch (...)
+    {
+      state.abort();
+      break;
+    }
+
+    state.push(std::move(job));
+  }
+
+  state.finish();
+  for (auto& worker : workers)
+    worker.join();
+
+  state.rethrow();
+  return state.progress;
+}
@@ -0,0 +1,92 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#include "libpak/header_range.hpp"
+#include "libpak/libpak.hpp"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+libpak::header_range::header_range(const std::filesystem::path& path, const size_t chunk_size)
+  : input(path, std::ios::binary)
+  , chunk_size(std::max<size_t>(chunk_size, 1))
+{
+  if (!this->input.is_open())
+    throw std::runtime_error("failed to open resource");
+
+  this->input.seekg(PAK_CONTENT_SECTOR);
+  this->input.read(reinterpret_cast<char*>(&this->content_header), sizeof(this->content_header));
+  if (!this->input.good())
+    throw std::runtime_error("failed to read content header");
+}
+
+libpak::header_range::iterator libpak::header_range::begin()
+{
+  if (this->headers_read != 0)
+    throw std::runtime_error("header range can be enumerated only once");
+
+  // the buffer is allocated once and reused for every chunk
+  this->chunk.reserve(std::min<size_t>(this->chunk_size, this->content_header.assets_count));
+  this->read_chunk();
+
+  return iterator(this);
+}
+
+void libpak::header_range::advance()
+{
+  this->chunk_index++;
+  if (this->is_exhausted())
+    this->read_chunk();
+}
+
+void libpak::header_range::read_chunk()
+{
+  this->chunk_index = 0;
+
+  const size_t count = std::min<size_t>(
+    this->chunk_size,
+    this->content_header.assets_count - this->headers_read);
+  this->chunk.resize(count);
+  if (count == 0)
+    return;
+
+  // the header table directly follows the content header
+  this->input.seekg(static_cast<std::streamoff>(
+    PAK_CONTENT_SECTOR + sizeof(libpak::content_header)
+    + static_cast<uint64_t>(this->headers_read) * sizeof(asset_header)));
+  this->input.read(
+    reinterpret_cast<char*>(this->chunk.data()),
+    static_cast<std::streamsize>(count * sizeof(asset_header)));
+  if (!this->input.good())
+    throw std::runtime_error(std::format("failed to read asset headers at {}", this->headers_read));
+
+  for (const auto& header : this->chunk)
+  {
+    if (header.path_length == 0x0)
+      throw std::runtime_error("invalid asset header read");
+  }
+
+  this->headers_read += static_cast<uint32_t>(count);
+}
+
+libpak::header_range libpak::resource::headers(const size_t chunk_size) const
+{
+  return header_range(this->resource_path, chunk_size);
+}
@@ -0,0 +1,320 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#include "libpak/libpak.hpp"
+#include "libpak/util.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+#include <zlib.h>
+
+namespace
+{
+
+//! Size of the buffer used to read the embedded data.
+constexpr uint64_t INFLATE_INPUT_SIZE = 64 * 1024;
+
+/**
+ * Reads a chunk of the embedded data.
+ * @param stream Resource stream.
+ * @param header Asset header.
+ * @param offset Offset in the embedded data.
+ * @param buffer Buffer.
+ * @return Number of bytes read.
+ */
+uInt read_embedded_chunk(
+  libpak::stream& stream,
+  const libpak::asset_header& header,
+  const uint64_t offset,
+  std::vector<std::byte>& buffer)
+{
+  const auto size = std::min<uint64_t>(
+    buffer.size(),
+    header.embedded_data_length - offset);
+  if (size == 0)
+    return 0;
+
+  if (!stream.read(
+        buffer.data(),
+        static_cast<int64_t>(size),
+        static_cast<int64_t>(header.embedded_data_offset + offset)))
+    throw std::runtime_error("couldn't read embedded data");
+
+  return static_cast<uInt>(size);
+}
+
+} // namespace
+
+std::vector<std::byte> libpak::resource::read(
+  const asset& asset,
+  const uint64_t offset,
+  const uint64_t length)
+{
+  const auto& header = asset.header;
+  if (!header.are_data_embedded)
+    return {};
+
+  // if data is not compressed, read just the range
+  if (not header.are_data_compressed)
+  {
+    if (offset >= header.embedded_data_length)
+      return {};
+
+    std::vector<std::byte> data(std::min<uint64_t>(
+      length,
+      header.embedded_data_length - offset));
+    if (!this->resource_stream->read(
+          data.data(),
+          static_cast<int64_t>(data.size()),
+          static_cast<int64_t>(header.embedded_data_offset + offset)))
+      throw std::runtime_error("couldn't read embedded data");
+    return data;
+  }
+
+  // find the nearest checkpoint preceding the range
+  const inflate_checkpoint* checkpoint = nullptr;
+  // the index is used only if it was built from the same embedded data
+  if (const auto cached_index = this->inflate_indices.find(asset.path());
+      cached_index != this->inflate_indices.end()
+      && cached_index->second->is_built_from(header))
+  {
+    const auto& checkpoints = cached_index->second->checkpoints;
+    const auto next_checkpoint = std::ranges::upper_bound(
+      checkpoints,
+      offset,
+      {},
+      &inflate_checkpoint::decompressed_offset);
+    if (next_checkpoint != checkpoints.begin())
+      checkpoint = &*std::prev(next_checkpoint);
+  }
+
+  z_stream inflate_stream{};
+  uint64_t embedded_offset = 0;
+  uint64_t decompressed_offset = 0;
+
+  std::vector<std::byte> input(INFLATE_INPUT_SIZE);
+
+  if (checkpoint == nullptr)
+  {
+    if (inflateInit(&inflate_stream) != Z_OK)
+      throw std::runtime_error("failed to initialize inflate");
+  }
+  else
+  {
+    // the checkpoint is in the middle of a deflate stream, inflate it raw
+    if (inflateInit2(&inflate_stream, -MAX_WBITS) != Z_OK)
+      throw std::runtime_error("failed to initialize inflate");
+
+    embedded_offset = checkpoint->embedded_offset;
+    decompressed_offset = checkpoint->decompressed_offset;
+
+    if (checkpoint->bits != 0)
+    {
+      std::byte preceding{};
+      if (!this->resource_stream->read(
+            &preceding,
+            1,
+            static_cast<int64_t>(header.embedded_data_offset + embedded_offset - 1)))
+      {
+        inflateEnd(&inflate_stream);
+        throw std::runtime_error("couldn't read embedded data");
+      }
+
+      inflatePrime(
+        &inflate_stream,
+        checkpoint->bits,
+        std::to_integer<int>(preceding) >> (8 - checkpoint->bits));
+    }
+
+    inflateSetDictionary(
+      &inflate_stream,
+      reinterpret_cast<const Bytef*>(checkpoint->window.data()),
+      static_cast<uInt>(checkpoint->window.size()));
+  }
+
+  util::defer end_inflate(
+    [&inflate_stream]()
+    {
+      inflateEnd(&inflate_stream);
+    });
+
+  std::vector<std::byte> data;
+  std::vector<std::byte> discarded(INFLATE_WINDOW_SIZE);
+
+  int inflate_result = Z_OK;
+  while (inflate_result != Z_STREAM_END && data.size() < length)
+  {
+    if (inflate_stream.avail_in == 0)
+    {
+      inflate_stream.avail_in = read_embedded_chunk(
+        *this->resource_stream, header, embedded_offset, input);
+      inflate_stream.next_in = reinterpret_cast<Bytef*>(input.data());
+      embedded_offset += inflate_stream.avail_in;
+
+      if (inflate_stream.avail_in == 0)
+        throw std::runtime_error("truncated compressed data");
+    }
+
+    // inflate into the discarded buffer until the range is reached
+    uint64_t output_size = 0;
+    if (decompressed_offset < offset)
+    {
+      output_size = std::min<uint64_t>(discarded.size(), offset - decompressed_offset);
+      inflate_stream.next_out = reinterpret_cast<Bytef*>(discarded.data());
+    }
+    else
+    {
+      const auto position = data.size();
+      output_size = std::min<uint64_t>(INFLATE_WINDOW_SIZE, length - position);
+      data.resize(position + output_size);
+      inflate_stream.next_out = reinterpret_cast<Bytef*>(data.data() + position);
+    }
+    inflate_stream.avail_out = static_cast<uInt>(output_size);
+
+    inflate_result = inflate(&inflate_stream, Z_NO_FLUSH);
+    switch (inflate_result)
+    {
+      case Z_NEED_DICT:
+      case Z_DATA_ERROR:
+        throw std::runtime_error("corrupted compressed data");
+      case Z_MEM_ERROR:
+        throw std::runtime_error("not enough memory for uncompressed data");
+      default:
+        {};
+        break;
+    }
+
+    const uint64_t produced = output_size - inflate_stream.avail_out;
+    if (decompressed_offset < offset)
+      decompressed_offset += produced;
+    else
+      data.resize(data.size() - inflate_stream.avail_out);
+  }
+
+  return data;
+}
+
+std::shared_ptr<const libpak::inflate_index> libpak::resource::build_inflate_index(
+  const asset& asset,
+  const uint64_t span)
+{
+  const auto& header = asset.header;
+  if (!header.are_data_embedded || !header.are_data_compressed)
+    throw std::runtime_error("asset data are not compressed");
+
+  z_stream inflate_stream{};
+  if (inflateInit(&inflate_stream) != Z_OK)
+    throw std::runtime_error("failed to initialize inflate");
+
+  util::defer end_inflate(
+    [&inflate_stream]()
+    {
+      inflateEnd(&inflate_stream);
+    });
+
+  auto index = std::make_shared<inflate_index>();
+  index->embedded_data_offset = header.embedded_data_offset;
+  index->embedded_data_length = header.embedded_data_length;
+  index->crc_embedded = header.crc_embedded;
+
+  std::vector<std::byte> input(INFLATE_INPUT_SIZE);
+  // circular window of the most recent decompressed data
+  std::vector<std::byte> window(INFLATE_WINDOW_SIZE);
+
+  uint64_t embedded_offset = 0;
+  uint64_t total_in = 0;
+  uint64_t total_out = 0;
+  uint64_t last_checkpoint = 0;
+
+  int inflate_result = Z_OK;
+  while (inflate_result != Z_STREAM_END)
+  {
+    inflate_stream.avail_in = read_embedded_chunk(
+      *this->resource_stream, header, embedded_offset, input);
+    inflate_stream.next_in = reinterpret_cast<Bytef*>(input.data());
+    embedded_offset += inflate_stream.avail_in;
+
+    if (inflate_stream.avail_in == 0)
+      throw std::runtime_error("truncated compressed data");
+
+    do
+    {
+      if (inflate_stream.avail_out == 0)
+      {
+        inflate_stream.avail_out = static_cast<uInt>(window.size());
+        inflate_stream.next_out = reinterpret_cast<Bytef*>(window.data());
+      }
+
+      total_in += inflate_stream.avail_in;
+      total_out += inflate_stream.avail_out;
+      // stop at the end of each deflate block
+      inflate_result = inflate(&inflate_stream, Z_BLOCK);
+      total_in -= inflate_stream.avail_in;
+      total_out -= inflate_stream.avail_out;
+
+      switch (inflate_result)
+      {
+        case Z_NEED_DICT:
+        case Z_DATA_ERROR:
+          throw std::runtime_error("corrupted compressed data");
+        case Z_MEM_ERROR:
+          throw std::runtime_error("not enough memory for uncompressed data");
+        default:
+          {};
+          break;
+      }
+
+      if (inflate_result == Z_STREAM_END)
+        break;
+
+      // add a checkpoint at the end of a block which is not the last one
+      const bool is_block_end = (inflate_stream.data_type & 128) != 0
+        && (inflate_stream.data_type & 64) == 0;
+      if (is_block_end && (total_out == 0 || total_out - last_checkpoint > span))
+      {
+        auto& checkpoint = index->checkpoints.emplace_back();
+        checkpoint.decompressed_offset = total_out;
+        checkpoint.embedded_offset = total_in;
+        checkpoint.bits = inflate_stream.data_type & 7;
+
+        // unwrap the circular window
+        const uint64_t left = inflate_stream.avail_out;
+        checkpoint.window.resize(window.size());
+        std::memcpy(
+          checkpoint.window.data(),
+          window.data() + window.size() - left,
+          left);
+        std::memcpy(
+          checkpoint.window.data() + left,
+          window.data(),
+          window.size() - left);
+
+        last_checkpoint = total_out;
+      }
+    } while (inflate_stream.avail_in != 0);
+  }
+
+  index->decompressed_length = total_out;
+
+  this->inflate_indices[asset.path()] = index;
+  return index;
+}
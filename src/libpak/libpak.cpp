@@ -20,7 +20,10 @@
 #include "libpak/libpak.hpp"
 #include "libpak/algorithms.hpp"
 #include "libpak/util.hpp"
+#include "libpak/writer.hpp"
 
+#include <chrono>
+#include <cstring>
 #include <filesystem>
 #include <format>
 #include <ranges>
@@ -31,21 +34,53 @@
 namespace
 {
 
-uLongf capitalized_string_crc32(const std::string& string)
+/**
+ * Finds an already written asset with the same data.
+ * @param candidates Written assets with the same data CRC.
+ * @param asset      Asset.
+ * @return Written asset or nullptr if there is none.
+ */
+const libpak::asset* find_duplicate_asset(
+  const std::vector<const libpak::asset*>& candidates,
+  const libpak::asset& asset)
 {
-  uLongf value{0};
-
-  for (char c : string)
+  const auto& buffer = asset.data.buffer;
+  for (const auto* candidate : candidates)
   {
-    c = static_cast<char>(std::toupper(c));
-
-    value = crc32(
-      value,
-      reinterpret_cast<const Bytef*>(&c),
-      sizeof(c));
+    // the CRC is only a hint, the decompressed data must be identical,
+    // regardless of whether they were compressed when written
+    if (candidate->data.buffer.size() == buffer.size()
+      && std::memcmp(candidate->data.buffer.data(), buffer.data(), buffer.size()) == 0)
+      return candidate;
   }
 
-  return value;
+  return nullptr;
+}
+
+/**
+ * Points the asset at the embedded data of the original asset.
+ * @param original Original asset.
+ * @param asset    Asset.
+ */
+void share_embedded_data(const libpak::asset& original, libpak::asset& asset)
+{
+  const auto& source = original.header;
+  auto& header = asset.header;
+
+  // the asset takes the compression of the original, the compression it
+  // was meant to have is remembered if the original was stored
+  const bool is_compressed = header.are_data_compressed || asset.is_compression_skipped;
+  header.are_data_compressed = source.are_data_compressed;
+  asset.is_compression_skipped = is_compressed && !source.are_data_compressed;
+
+  header.embedded_data_offset = source.embedded_data_offset;
+  header.embedded_data_length = source.embedded_data_length;
+  header.data_decompressed_length = source.data_decompressed_length;
+
+  header.crc_decompressed = source.crc_decompressed;
+  header.checksum_decompressed = source.checksum_decompressed;
+  header.crc_embedded = source.crc_embedded;
+  header.checksum_embedded = source.checksum_embedded;
 }
 
 /**
@@ -157,9 +192,57 @@ libpak::stream::stream(
 {
 }
 
+libpak::resource::resource(const resource& other)
+  : resource_path(other.resource_path)
+  , pak_header(other.pak_header)
+  , content_header(other.content_header)
+  , data_header(other.data_header)
+  , arena(other.arena != nullptr ? std::make_unique<std::pmr::monotonic_buffer_resource>() : nullptr)
+  , assets(other.assets, arena != nullptr ? arena.get() : std::pmr::get_default_resource())
+  , inflate_indices(other.inflate_indices)
+  , embedded_buffer(other.embedded_buffer)
+  , resource_stream(other.resource_stream)
+  , input_stream(other.input_stream)
+  , output_stream(other.output_stream)
+{
+}
+
+libpak::resource& libpak::resource::operator=(const resource& other)
+{
+  if (this != &other)
+    *this = resource(other);
+  return *this;
+}
+
+libpak::resource& libpak::resource::operator=(resource&& other) noexcept
+{
+  if (this == &other)
+    return *this;
+
+  this->destroy();
+
+  this->resource_path = std::move(other.resource_path);
+  this->pak_header = other.pak_header;
+  this->content_header = other.content_header;
+  this->data_header = other.data_header;
+
+  // the allocator of the asset index isn't propagated by assignment,
+  // the index is re-created from the other one so that it keeps its arena
+  std::destroy_at(&this->assets);
+  std::construct_at(&this->assets, std::move(other.assets));
+  this->arena = std::move(other.arena);
+
+  this->inflate_indices = std::move(other.inflate_indices);
+  this->embedded_buffer = std::move(other.embedded_buffer);
+  this->resource_stream = std::move(other.resource_stream);
+  this->input_stream = std::move(other.input_stream);
+  this->output_stream = std::move(other.output_stream);
+  return *this;
+}
+
 void libpak::resource::create() {}
 
-void libpak::resource::read(const bool data)
+void libpak::resource::open()
 {
   // input stream
   this->input_stream = std::make_shared<std::ifstream>(
@@ -180,6 +263,14 @@ void libpak::resource::read(const bool data)
   if (!this->resource_stream->read(this->content_header))
     throw std::runtime_error("failed to read content header");
 
+  // the asset data may have changed since the indices were built
+  this->inflate_indices.clear();
+}
+
+void libpak::resource::read(const bool data)
+{
+  this->open();
+
   // reserve the size of asset count
   this->assets.reserve(this->content_header.assets_count);
 
@@ -205,7 +296,7 @@ void libpak::resource::read(const bool data)
       }
 
       // index asset
-      this->assets[asset.path()] = std::move(asset);
+      this->assets.insert_or_assign(asset.path(), std::move(asset));
     }
     catch (const std::runtime_error& e)
     {
@@ -214,58 +305,109 @@ void libpak::resource::read(const bool data)
   }
 }
 
-void libpak::resource::write()
+libpak::write_result libpak::resource::write(const write_options& options)
 {
-  // input stream
-  this->output_stream = std::make_shared<std::ofstream>(
-    this->resource_path, std::ios::binary);
+  return this->write(this->resource_path, options);
+}
+
+libpak::write_result libpak::resource::write(const std::string& path, const write_options& options)
+{
+  write_result result;
+  const auto write_start = std::chrono::steady_clock::now();
+
+  // plan the compression levels of the assets
+  std::unordered_map<const asset*, int> compression_levels;
+  if (options.compression.is_set())
+  {
+    std::vector<const asset*> planned_assets;
+    planned_assets.reserve(this->assets.size());
+    for (const auto& asset : this->assets | std::views::values)
+      planned_assets.emplace_back(&asset);
+
+    const auto plan = plan_compression(planned_assets, options.compression);
+    for (size_t index = 0; index < planned_assets.size(); index++)
+      compression_levels.emplace(planned_assets[index], plan.levels[index]);
+  }
+
+  writer writer(path, this->assets.size());
+
   // resource stream wrapper
+  this->output_stream = writer.output;
   this->resource_stream = std::make_shared<stream>(
     this->input_stream, this->output_stream);
 
-  this->resource_stream->set_writer_cursor(0);
-
-  // Update the content header
-  this->content_header.assets_count = static_cast<uint32_t>(this->assets.size());
+  util::defer release_output(
+    [this]()
+    {
+      this->output_stream.reset();
+      this->resource_stream = std::make_shared<stream>(
+        this->input_stream, this->output_stream);
+    });
 
-  // write the content header
-  this->resource_stream->set_writer_cursor(PAK_CONTENT_SECTOR);
-  if (!this->resource_stream->write(this->content_header))
-    throw std::runtime_error("failed to write content header");
+  // written assets indexed by the CRC of their data, used for deduplication
+  std::unordered_map<uint32_t, std::vector<const asset*>> written_assets;
 
-  int64_t data_offset = PAK_DATA_SECTOR;
   for (auto& asset : this->assets | std::views::values)
   {
-    const auto header_origin = this->resource_stream->set_writer_cursor(
-      data_offset);
-    this->write_asset_data(asset);
+    const libpak::asset* original = nullptr;
+    // the CRC of the data is reused by the write of the asset data
+    std::optional<uint32_t> data_crc;
+    if (options.deduplicate && asset.header.are_data_embedded && !asset.data.buffer.empty())
+    {
+      data_crc = static_cast<uint32_t>(crc32(
+        0, // initial crc cycle value
+        reinterpret_cast<const Bytef*>(asset.data.buffer.data()),
+        static_cast<uInt>(asset.data.buffer.size())));
+      original = find_duplicate_asset(written_assets[*data_crc], asset);
+    }
 
-    // Return to the asset header origin
-    this->resource_stream->set_writer_cursor(header_origin);
+    if (original != nullptr)
+    {
+      share_embedded_data(*original, asset);
 
-    this->write_asset_header(asset);
+      result.deduplicated_assets++;
+      result.deduplicated_bytes += asset.header.embedded_data_length;
+    }
+    else
+    {
+      this->write_asset_data(
+        asset,
+        compression_levels.empty() ? DEFAULT_COMPRESSION_LEVEL : compression_levels.at(&asset),
+        data_crc);
+      if (asset.header.are_data_embedded)
+      {
+        result.input_bytes += asset.data.buffer.size();
+        result.embedded_bytes += asset.header.embedded_data_length;
+      }
+      if (data_crc.has_value())
+        written_assets[*data_crc].emplace_back(&asset);
+    }
 
-    // Offset the data cursor by the length of the embedded data.
-    data_offset += asset.header.embedded_data_length;
+    writer.add_header(asset.header);
   }
 
-  if (!this->resource_stream->write(this->data_header))
-    throw std::runtime_error("failed to write data header");
+  writer.commit(this->pak_header, this->content_header, this->data_header);
 
-  // Update the intro PAKS header assets counts
-  this->pak_header.assets_count = static_cast<uint32_t>(this->assets.size());
-  this->pak_header.used_assets_count = static_cast<uint32_t>(this->assets.size());
-  this->pak_header.deleted_assets_count = 0;
+  // the resource was replaced, reopen the input stream
+  std::error_code error;
+  if (this->input_stream != nullptr
+    && std::filesystem::equivalent(path, this->resource_path, error))
+  {
+    this->input_stream = std::make_shared<std::ifstream>(
+      this->resource_path, std::ios::binary);
+  }
 
-  this->pak_header.file_size = static_cast<uint32_t>(
-    this->resource_stream->get_writer_cursor());
+  // the assets were compressed again
+  this->inflate_indices.clear();
 
-  // Write the intro PAKS header
-  this->resource_stream->set_writer_cursor(0);
-  if (!this->resource_stream->write(this->pak_header))
-    throw std::runtime_error("failed to write pak header");
+  const std::chrono::duration<double> write_time = std::chrono::steady_clock::now() - write_start;
+  if (result.input_bytes != 0)
+    result.compression_ratio = static_cast<double>(result.embedded_bytes)
+      / static_cast<double>(result.input_bytes);
+  if (write_time.count() > 0)
+    result.throughput = static_cast<double>(result.input_bytes) / write_time.count();
 
-  this->output_stream->close();
+  return result;
 }
 
 void libpak::resource::read_asset_header(asset& asset)
@@ -280,21 +422,14 @@ void libpak::resource::read_asset_header(asset& asset)
     throw std::runtime_error("invalid asset header read");
 }
 
-void libpak::resource::read_asset_data(asset& asset)
+void libpak::resource::read_asset_embedded_data(const asset& asset, std::vector<std::byte>& buffer)
 {
-  auto& header = asset.header;
-  auto& data = asset.data;
-  if (!header.are_data_embedded)
-    return;
-
-  uLongf embedded_size = asset.header.embedded_data_length;
-  const int64_t embedded_data_offset = header.embedded_data_offset;
+  const auto& header = asset.header;
 
   // allocate embedded data buffer
-  std::vector<std::byte> embedded_data;
   try
   {
-    embedded_data.resize(embedded_size);
+    buffer.resize(header.embedded_data_length);
   }
   catch (std::bad_alloc&)
   {
@@ -302,53 +437,44 @@ void libpak::resource::read_asset_data(asset& asset)
   }
 
   // read the embedded data
-  if (!this->resource_stream->read(embedded_data.data(), embedded_size, embedded_data_offset))
+  if (!this->resource_stream->read(buffer.data(), header.embedded_data_length, header.embedded_data_offset))
     throw std::runtime_error("couldn't read embedded data");
+}
 
-  // if data is not compressed, return the unprocessed buffer
+void libpak::resource::read_asset_data(asset& asset)
+{
+  auto& header = asset.header;
+  auto& data = asset.data;
+  if (!header.are_data_embedded)
+    return;
+
+  // if data is not compressed, read them straight into the data buffer
   if (not header.are_data_compressed)
   {
-    asset.data.buffer = std::move(embedded_data);
+    try
+    {
+      data.buffer.resize(header.embedded_data_length);
+    }
+    catch (std::bad_alloc&)
+    {
+      throw std::runtime_error("not enough memory for data buffer");
+    }
+
+    if (!this->resource_stream->read(data.buffer.data(), header.embedded_data_length, header.embedded_data_offset))
+      throw std::runtime_error("couldn't read embedded data");
     return;
   }
 
-  // NPAK can compress small buffers and inflate them. Because to this,
-  // choose the largest data size for the decompressed data buffer.
-  uLongf decompressed_data_size = std::max(
-    header.embedded_data_length,
-    header.data_decompressed_length);
-
-  // allocate buffer for data
-  try
-  {
-    data.buffer.resize(decompressed_data_size);
-  }
-  catch (std::bad_alloc&)
-  {
-    throw std::runtime_error("not enough memory for data buffer");
-  }
+  // the embedded data buffer is reused between the reads
+  auto& embedded_data = this->embedded_buffer;
+  this->read_asset_embedded_data(asset, embedded_data);
 
   // uncompress
-  const auto compression_result = uncompress2(
-    reinterpret_cast<Bytef*>(data.buffer.data()),
-    &decompressed_data_size,
-    reinterpret_cast<Bytef*>(embedded_data.data()),
-    &embedded_size);
-
-  if (decompressed_data_size > data.buffer.size())
-    data.buffer.resize(decompressed_data_size);
-
-  switch (compression_result)
-  {
-    case Z_BUF_ERROR:
-    case Z_MEM_ERROR:
-      throw std::runtime_error("not enough memory for uncompressed data");
-    case Z_DATA_ERROR:
-      throw std::runtime_error("corrupted compressed data");
-    default:
-      {};
-      break;
-  }
+  alg::decompress_embedded_data(
+    embedded_data.data(),
+    embedded_data.size(),
+    header.data_decompressed_length,
+    data.buffer);
 }
 
 void libpak::resource::write_asset_header(asset& asset)
@@ -359,45 +485,38 @@ void libpak::resource::write_asset_header(asset& asset)
   header.header_offset = static_cast<uint32_t>(
     this->resource_stream->get_writer_cursor());
 
-  const std::filesystem::path path(asset.header.path);
-
-  // update path hash
-  const auto path_string = path.string();
-  // path length includes the zero terminator
-  header.path_length = static_cast<uint32_t>(
-    path_string.length() + 1);
-  header.path_hash = capitalized_string_crc32(path_string);
-
-  // update filename hash
-  const std::string filename_string = path.filename().string();
-  header.filename_hash = capitalized_string_crc32(filename_string);
-
-  // update extension hash
-  const std::string extension_string = path.extension().string();
-  header.extension_hash = capitalized_string_crc32(extension_string);
-
-  // update parent path hash
-  const std::string parent_path_string = path.parent_path().string();
-  header.parent_path_hash = capitalized_string_crc32(parent_path_string);
+  writer::update_header_hashes(header);
 
   // write the asset header
   if (!this->resource_stream->write(header))
     throw std::runtime_error("failed to write asset header");
 }
 
-void libpak::resource::write_asset_data(asset& asset)
+void libpak::resource::write_asset_data(
+  asset& asset,
+  const int level,
+  const std::optional<uint32_t> data_crc)
 {
   if (not asset.header.are_data_embedded || asset.data.buffer.empty())
     return;
 
+  // the header describes the written data, the compression skipped
+  // at the stored level is remembered for the next write
+  const bool is_compressed = asset.header.are_data_compressed || asset.is_compression_skipped;
+  asset.header.are_data_compressed = is_compressed && level != STORED_COMPRESSION_LEVEL;
+  asset.is_compression_skipped = is_compressed && level == STORED_COMPRESSION_LEVEL;
+
   asset.header.data_decompressed_length = static_cast<uint32_t>(
       asset.data.buffer.size());
 
-  // calculate the CRC and checksum of the decompressed data.
-  const uLongf decompressed_crc = crc32(
-    0, // initial crc cycle value
-    reinterpret_cast<const Bytef*>(asset.data.buffer.data()),
-    asset.header.data_decompressed_length);
+  // calculate the CRC and checksum of the decompressed data,
+  // the CRC may have been computed already for the deduplication
+  const uLongf decompressed_crc = data_crc.has_value()
+    ? *data_crc
+    : crc32(
+        0, // initial crc cycle value
+        reinterpret_cast<const Bytef*>(asset.data.buffer.data()),
+        asset.header.data_decompressed_length);
 
   const uint32_t decompressed_checksum = alicia_checksum(
     reinterpret_cast<const char*>(asset.data.buffer.data()),
@@ -411,19 +530,13 @@ void libpak::resource::write_asset_data(asset& asset)
 
   if (asset.header.are_data_compressed)
   {
-    uLongf compressed_size = std::max(
-      asset.header.data_decompressed_length,
-      asset.header.embedded_data_length);
-
     std::vector<std::byte> compressed_data_buffer;
-    compressed_data_buffer.resize(compressed_size);
-
-    compress2(
-      reinterpret_cast<Bytef*>(compressed_data_buffer.data()),
-      &compressed_size,
-      reinterpret_cast<Bytef*>(asset.data.buffer.data()),
+    alg::compress(
+      asset.data.buffer.data(),
       asset.header.data_decompressed_length,
-      9 /* compression level*/);
+      compressed_data_buffer,
+      level);
+    const auto compressed_size = static_cast<uint32_t>(compressed_data_buffer.size());
 
     // calculate the crc and checksum of the now compressed data
 
@@ -465,10 +578,31 @@ void libpak::resource::write_asset_data(asset& asset)
   asset.header.checksum_embedded = embedded_checksum;
 }
 
+libpak::asset& libpak::resource::operator[](const std::u16string_view name)
+{
+  const auto asset = this->assets.find(name);
+  if (asset == this->assets.end())
+    throw std::out_of_range("asset not found");
+  return asset->second;
+}
+
 void libpak::resource::destroy() noexcept
 {
   this->pak_header = {};
   this->content_header = {};
   this->data_header = {};
-  this->assets.clear();
+  this->inflate_indices.clear();
+  this->embedded_buffer = {};
+
+  if (this->arena == nullptr)
+  {
+    this->assets.clear();
+    return;
+  }
+
+  // The assets are destroyed for their paths and data, but the nodes and the buckets
+  // of the index aren't freed one by one, they are released with the arena at once.
+  std::destroy_at(&this->assets);
+  this->arena->release();
+  std::construct_at(&this->assets, this->arena.get());
 }
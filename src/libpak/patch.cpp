@@ -0,0 +1,395 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#include "libpak/patch.hpp"
+#include "libpak/algorithms.hpp"
+#include "libpak/util.hpp"
+
+#include <cstring>
+#include <format>
+#include <map>
+#include <ranges>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <zlib.h>
+
+namespace
+{
+
+/**
+ * Reads the header table of the resource. The table is read from the resource
+ * itself, so that assets sharing a path are all accounted for.
+ * @param resource Resource. Must be read.
+ * @return Asset headers.
+ */
+std::vector<libpak::asset_header> read_header_table(libpak::resource& resource)
+{
+  std::vector<libpak::asset_header> headers(resource.content_header.assets_count);
+
+  int64_t offset = libpak::PAK_CONTENT_SECTOR + sizeof(libpak::content_header);
+  for (auto& header : headers)
+  {
+    if (!resource.resource_stream->read(header, offset))
+      throw std::runtime_error("failed to read asset header");
+    offset += sizeof(libpak::asset_header);
+  }
+
+  return headers;
+}
+
+/**
+ * @param source Source asset header.
+ * @param target Target asset header.
+ * @return True if the embedded data of both assets are the same, otherwise returns false.
+ */
+bool is_embedded_data_unchanged(const libpak::asset_header& source, const libpak::asset_header& target)
+{
+  return source.are_data_embedded
+    && source.embedded_data_length == target.embedded_data_length
+    && source.are_data_compressed == target.are_data_compressed
+    && source.crc_embedded == target.crc_embedded
+    && source.crc_decompressed == target.crc_decompressed;
+}
+
+/**
+ * @param header Asset header.
+ * @return True if the asset has embedded data, otherwise returns false.
+ */
+bool has_embedded_data(const libpak::asset_header& header)
+{
+  return header.are_data_embedded && header.embedded_data_length != 0;
+}
+
+/**
+ * @param source Source asset header.
+ * @param target Target asset header.
+ * @return True if the headers are the same apart from their header and embedded
+ * data offsets, otherwise returns false.
+ */
+bool is_header_unchanged(const libpak::asset_header& source, const libpak::asset_header& target)
+{
+  libpak::asset_header relocated = source;
+  relocated.header_offset = target.header_offset;
+  relocated.embedded_data_offset = target.embedded_data_offset;
+  return std::memcmp(&relocated, &target, sizeof(libpak::asset_header)) == 0;
+}
+
+/**
+ * Size of the patch table when decompressed.
+ * @param header Patch header.
+ * @return Size of the table.
+ */
+uint64_t table_size(const libpak::patch::patch_header& header)
+{
+  return header.references_count * sizeof(libpak::patch::patch_reference)
+    + header.entries_count * sizeof(libpak::patch::patch_entry);
+}
+
+} // namespace
+
+libpak::patch::generate_result libpak::patch::generate(
+  resource& source,
+  resource& target,
+  const std::filesystem::path& patch_path)
+{
+  generate_result result;
+
+  patch_header header;
+  header.source_size = std::filesystem::file_size(source.resource_path);
+  header.target_size = std::filesystem::file_size(target.resource_path);
+  header.pak_header = target.pak_header;
+  header.content_header = target.content_header;
+
+  const auto source_headers = read_header_table(source);
+  const auto target_headers = read_header_table(target);
+
+  // source assets indexed by their path, the last asset with a path wins as in the asset index
+  std::unordered_map<std::u16string_view, uint32_t> source_indices;
+  for (uint32_t index = 0; index < source_headers.size(); index++)
+    source_indices.insert_or_assign(source_headers[index].path, index);
+
+  std::vector<patch_reference> references;
+  std::vector<patch_entry> entries;
+
+  // embedded data stored in the patch, indexed by their target offset
+  std::map<uint32_t, const asset_header*> patch_data;
+  // offset of the embedded data in the patch, indexed by their target offset
+  std::map<uint32_t, uint64_t> patch_data_offsets;
+
+  for (const auto& target_header : target_headers)
+  {
+    const auto source_index = source_indices.find(target_header.path);
+    const asset_header* const source_header = source_index != source_indices.end()
+      ? &source_headers[source_index->second]
+      : nullptr;
+
+    // the unchanged assets are only referenced
+    if (source_header != nullptr && is_header_unchanged(*source_header, target_header))
+    {
+      references.emplace_back(patch_reference{
+        .source_index = source_index->second,
+        .header_offset = target_header.header_offset,
+        .embedded_data_offset = target_header.embedded_data_offset});
+      if (has_embedded_data(target_header))
+        result.unchanged_assets++;
+      continue;
+    }
+
+    auto& entry = entries.emplace_back();
+    entry.header = target_header;
+
+    if (!has_embedded_data(target_header))
+      continue;
+
+    if (source_header != nullptr && is_embedded_data_unchanged(*source_header, target_header))
+    {
+      entry.data_origin = patch_entry::origin::source;
+      entry.data_offset = source_header->embedded_data_offset;
+      result.unchanged_assets++;
+      continue;
+    }
+
+    entry.data_origin = patch_entry::origin::patch;
+    patch_data.try_emplace(target_header.embedded_data_offset, &target_header);
+    result.changed_assets++;
+  }
+
+  std::unordered_set<std::u16string_view> target_paths;
+  for (const auto& target_header : target_headers)
+    target_paths.emplace(target_header.path);
+
+  for (const auto& path : source.assets | std::views::keys)
+  {
+    if (!target_paths.contains(path))
+      result.removed_assets++;
+  }
+
+  // lay the embedded data out behind the patch table
+  uint64_t data_offset = 0;
+  for (const auto& [target_offset, target_header] : patch_data)
+  {
+    patch_data_offsets[target_offset] = data_offset;
+    data_offset += target_header->embedded_data_length;
+  }
+
+  for (auto& entry : entries)
+  {
+    if (entry.data_origin == patch_entry::origin::patch)
+      entry.data_offset = patch_data_offsets[entry.header.embedded_data_offset];
+  }
+
+  header.references_count = static_cast<uint32_t>(references.size());
+  header.entries_count = static_cast<uint32_t>(entries.size());
+
+  // the references and entries are deflated as one table
+  std::vector<std::byte> table(table_size(header));
+  std::memcpy(table.data(), references.data(), references.size() * sizeof(patch_reference));
+  std::memcpy(
+    table.data() + references.size() * sizeof(patch_reference),
+    entries.data(),
+    entries.size() * sizeof(patch_entry));
+
+  std::vector<std::byte> deflated_table;
+  alg::compress(table.data(), table.size(), deflated_table, Z_BEST_COMPRESSION);
+  header.table_length = deflated_table.size();
+
+  std::ofstream patch(patch_path, std::ios::binary | std::ios::trunc);
+  if (!patch.is_open())
+    throw std::runtime_error("failed to create patch");
+
+  patch.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  patch.write(
+    reinterpret_cast<const char*>(deflated_table.data()),
+    static_cast<std::streamsize>(deflated_table.size()));
+
+  // copy the embedded data as they are
+  std::vector<std::byte> buffer;
+  for (const auto& target_header : patch_data | std::views::values)
+  {
+    asset asset;
+    asset.header = *target_header;
+    target.read_asset_embedded_data(asset, buffer);
+
+    patch.write(
+      reinterpret_cast<const char*>(buffer.data()),
+      static_cast<std::streamsize>(buffer.size()));
+  }
+
+  if (!patch.good())
+    throw std::runtime_error("failed to write patch");
+
+  result.patch_size = static_cast<uint64_t>(patch.tellp());
+  return result;
+}
+
+void libpak::patch::apply(
+  resource& source,
+  const std::filesystem::path& patch_path,
+  const std::filesystem::path& target_path)
+{
+  if (std::filesystem::exists(target_path)
+    && std::filesystem::equivalent(target_path, source.resource_path))
+    throw std::runtime_error("patch can't be applied in place");
+
+  std::ifstream patch(patch_path, std::ios::binary);
+  if (!patch.is_open())
+    throw std::runtime_error("failed to open patch");
+
+  patch_header header;
+  patch.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!patch.good() || header.magic != patch_header{}.magic)
+    throw std::runtime_error("invalid patch header");
+  if (header.version != patch_header{}.version)
+    throw std::runtime_error(std::format("unsupported patch version {}", header.version));
+  if (header.source_size != std::filesystem::file_size(source.resource_path))
+    throw std::runtime_error("patch doesn't match the source resource");
+
+  std::vector<std::byte> deflated_table(header.table_length);
+  patch.read(
+    reinterpret_cast<char*>(deflated_table.data()),
+    static_cast<std::streamsize>(deflated_table.size()));
+  if (!patch.good())
+    throw std::runtime_error("failed to read patch table");
+
+  std::vector<std::byte> table(table_size(header));
+  if (alg::decompress(deflated_table.data(), deflated_table.size(), table.data(), table.size())
+    != table.size())
+    throw std::runtime_error("invalid patch table");
+
+  // the embedded data stored in the patch follow the table
+  const uint64_t data_section = sizeof(patch_header) + header.table_length;
+
+  std::vector<patch_reference> references(header.references_count);
+  std::memcpy(references.data(), table.data(), references.size() * sizeof(patch_reference));
+
+  std::vector<patch_entry> entries(header.entries_count);
+  std::memcpy(
+    entries.data(),
+    table.data() + references.size() * sizeof(patch_reference),
+    entries.size() * sizeof(patch_entry));
+
+  // the referenced assets are restored from the source header table
+  const auto source_headers = read_header_table(source);
+  entries.reserve(entries.size() + references.size());
+  for (const auto& reference : references)
+  {
+    if (reference.source_index >= source_headers.size())
+      throw std::runtime_error("invalid patch reference");
+
+    const auto& source_header = source_headers[reference.source_index];
+    auto& entry = entries.emplace_back();
+    entry.header = source_header;
+    entry.header.header_offset = reference.header_offset;
+    entry.header.embedded_data_offset = reference.embedded_data_offset;
+
+    if (has_embedded_data(source_header))
+    {
+      entry.data_origin = patch_entry::origin::source;
+      entry.data_offset = source_header.embedded_data_offset;
+    }
+  }
+
+  std::ofstream target(target_path, std::ios::binary | std::ios::trunc);
+  if (!target.is_open())
+    throw std::runtime_error("failed to create target resource");
+
+  // remove the incomplete target resource on failure
+  bool is_applied = false;
+  util::defer remove_target(
+    [&]()
+    {
+      if (is_applied)
+        return;
+      target.close();
+      std::error_code error;
+      std::filesystem::remove(target_path, error);
+    });
+
+  // the embedded data of the target resource, in the order of their target offset
+  std::map<uint32_t, const patch_entry*> target_data;
+  for (const auto& entry : entries)
+  {
+    if (entry.data_origin != patch_entry::origin::none)
+      target_data.try_emplace(entry.header.embedded_data_offset, &entry);
+  }
+
+  std::vector<std::byte> buffer;
+  for (const auto& [target_offset, entry] : target_data)
+  {
+    if (entry->data_origin == patch_entry::origin::source)
+    {
+      asset asset;
+      asset.header = entry->header;
+      asset.header.embedded_data_offset = static_cast<uint32_t>(entry->data_offset);
+      source.read_asset_embedded_data(asset, buffer);
+    }
+    else
+    {
+      buffer.resize(entry->header.embedded_data_length);
+      patch.seekg(static_cast<std::streamoff>(data_section + entry->data_offset));
+      patch.read(
+        reinterpret_cast<char*>(buffer.data()),
+        static_cast<std::streamsize>(buffer.size()));
+      if (!patch.good())
+        throw std::runtime_error("failed to read patch data");
+    }
+
+    const auto crc = crc32(
+      0, // initial crc cycle value
+      reinterpret_cast<const Bytef*>(buffer.data()),
+      static_cast<uInt>(buffer.size()));
+    if (crc != entry->header.crc_embedded)
+      throw std::runtime_error(std::format(
+        "embedded data at {} failed CRC verification", target_offset));
+
+    target.seekp(target_offset);
+    target.write(
+      reinterpret_cast<const char*>(buffer.data()),
+      static_cast<std::streamsize>(buffer.size()));
+  }
+
+  // write the headers
+  target.seekp(0);
+  target.write(reinterpret_cast<const char*>(&header.pak_header), sizeof(header.pak_header));
+
+  target.seekp(PAK_CONTENT_SECTOR);
+  target.write(reinterpret_cast<const char*>(&header.content_header), sizeof(header.content_header));
+
+  for (const auto& entry : entries)
+  {
+    target.seekp(entry.header.header_offset);
+    target.write(reinterpret_cast<const char*>(&entry.header), sizeof(entry.header));
+  }
+
+  if (header.pak_header.file_size >= sizeof(data_header))
+  {
+    const data_header data_header;
+    target.seekp(header.pak_header.file_size - sizeof(data_header));
+    target.write(reinterpret_cast<const char*>(&data_header), sizeof(data_header));
+  }
+
+  if (!target.good())
+    throw std::runtime_error("failed to write target resource");
+  target.close();
+
+  std::filesystem::resize_file(target_path, header.target_size);
+  is_applied = true;
+}
@@ -0,0 +1,448 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#include "libpak/path_index.hpp"
+#include "libpak/algorithms.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <optional>
+#include <ranges>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define LIBPAK_SSE2
+  #include <emmintrin.h>
+#endif
+
+namespace
+{
+
+/**
+ * Represents a token of a compiled glob.
+ */
+struct glob_token
+{
+  enum class kind
+  {
+    //! Matches the text.
+    literal,
+    //! Matches a character except a separator.
+    any,
+    //! Matches any characters except a separator.
+    star,
+    //! Matches any characters.
+    globstar,
+    //! Matches any number of directories, including none.
+    globstar_directory,
+  };
+
+  kind type{kind::literal};
+  std::u16string text;
+};
+
+/**
+ * @param character Character.
+ * @return Character in the form stored in the path arena.
+ */
+char16_t normalize(const char16_t character) noexcept
+{
+  if (character == u'\\')
+    return u'/';
+  if (character >= u'a' && character <= u'z')
+    return static_cast<char16_t>(character - (u'a' - u'A'));
+  return character;
+}
+
+/**
+ * @param string String.
+ * @return String in the form stored in the path arena.
+ */
+std::u16string normalize(const std::u16string_view string)
+{
+  std::u16string normalized(string.size(), u'\0');
+  std::ranges::transform(string, normalized.begin(), [](const char16_t character) { return normalize(character); });
+  return normalized;
+}
+
+/**
+ * @param lhs    First string.
+ * @param rhs    Second string.
+ * @param length Length of both strings.
+ * @return True if the strings are equal, otherwise returns false.
+ */
+bool equal(const char16_t* lhs, const char16_t* rhs, const size_t length) noexcept
+{
+  size_t index = 0;
+#ifdef LIBPAK_SSE2
+  for (; index + 8 <= length; index += 8)
+  {
+    const __m128i lhs_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + index));
+    const __m128i rhs_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + index));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(lhs_block, rhs_block)) != 0xFFFF)
+      return false;
+  }
+#endif
+
+  for (; index < length; index++)
+  {
+    if (lhs[index] != rhs[index])
+      return false;
+  }
+  return true;
+}
+
+/**
+ * Finds the first occurrence of either of the characters.
+ * @param string String.
+ * @param from   Position to start at.
+ * @param first  First character.
+ * @param second Second character.
+ * @return Position of the character, or npos if there is none.
+ */
+size_t find_either(
+  const std::u16string_view string,
+  size_t from,
+  const char16_t first,
+  const char16_t second) noexcept
+{
+#ifdef LIBPAK_SSE2
+  const __m128i first_block = _mm_set1_epi16(static_cast<short>(first));
+  const __m128i second_block = _mm_set1_epi16(static_cast<short>(second));
+  for (; from + 8 <= string.size(); from += 8)
+  {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(string.data() + from));
+    const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(
+      _mm_cmpeq_epi16(block, first_block),
+      _mm_cmpeq_epi16(block, second_block))));
+    // every character sets two bits of the mask
+    if (mask != 0)
+      return from + std::countr_zero(mask) / 2;
+  }
+#endif
+
+  for (; from < string.size(); from++)
+  {
+    if (string[from] == first || string[from] == second)
+      return from;
+  }
+  return std::u16string_view::npos;
+}
+
+/**
+ * Hashes the string like the asset header hashes are computed.
+ * @param string    Normalized string.
+ * @param separator Separator the string is hashed with.
+ * @return Hash, or nothing if the string can't be hashed.
+ */
+std::optional<uint32_t> hash_string(const std::u16string_view string, const char16_t separator)
+{
+  std::string narrow;
+  narrow.reserve(string.size());
+  for (const char16_t character : string)
+  {
+    // the headers hash the multibyte form of the path, which isn't reproduced here
+    if (character > 0x7F)
+      return std::nullopt;
+    narrow.push_back(static_cast<char>(character == u'/' ? separator : character));
+  }
+  return libpak::alg::capitalized_string_crc32(narrow);
+}
+
+/**
+ * @param path Normalized path.
+ * @return Parent path.
+ */
+std::u16string_view parent_path(const std::u16string_view path) noexcept
+{
+  const auto separator = path.rfind(u'/');
+  return separator == std::u16string_view::npos ? std::u16string_view{} : path.substr(0, separator);
+}
+
+/**
+ * @param path Normalized path.
+ * @return Extension including the dot, or empty if there is none.
+ */
+std::u16string_view extension(const std::u16string_view path) noexcept
+{
+  const auto separator = path.rfind(u'/');
+  const auto filename = separator == std::u16string_view::npos ? path : path.substr(separator + 1);
+  const auto dot = filename.rfind(u'.');
+  // a leading dot doesn't start an extension
+  return dot == std::u16string_view::npos || dot == 0 ? std::u16string_view{} : filename.substr(dot);
+}
+
+/**
+ * Compiles the glob into tokens.
+ * @param pattern Normalized glob.
+ * @return Tokens.
+ */
+std::vector<glob_token> compile_glob(const std::u16string_view pattern)
+{
+  std::vector<glob_token> tokens;
+  for (size_t index = 0; index < pattern.size(); index++)
+  {
+    const char16_t character = pattern[index];
+    if (character == u'?')
+    {
+      tokens.push_back({.type = glob_token::kind::any, .text = {}});
+    }
+    else if (character == u'*')
+    {
+      if (index + 1 < pattern.size() && pattern[index + 1] == u'*')
+      {
+        index++;
+        if (index + 1 < pattern.size() && pattern[index + 1] == u'/')
+        {
+          index++;
+          tokens.push_back({.type = glob_token::kind::globstar_directory, .text = {}});
+        }
+        else
+        {
+          tokens.push_back({.type = glob_token::kind::globstar, .text = {}});
+        }
+      }
+      else
+      {
+        tokens.push_back({.type = glob_token::kind::star, .text = {}});
+      }
+    }
+    else
+    {
+      if (tokens.empty() || tokens.back().type != glob_token::kind::literal)
+        tokens.push_back({.type = glob_token::kind::literal, .text = {}});
+      tokens.back().text.push_back(character);
+    }
+  }
+  return tokens;
+}
+
+/**
+ * Matches the path against the tokens.
+ * @param tokens Tokens.
+ * @param token  Index of the token to match.
+ * @param path   Normalized path.
+ * @param offset Offset in the path to match at.
+ * @return True if the rest of the path matches the rest of the tokens, otherwise returns false.
+ */
+bool match_glob(
+  const std::vector<glob_token>& tokens,
+  const size_t token,
+  const std::u16string_view path,
+  const size_t offset)
+{
+  if (token == tokens.size())
+    return offset == path.size();
+
+  const auto& current = tokens[token];
+  // the positions a wildcard can end at are narrowed to the first character of the next literal
+  const bool is_followed_by_literal = token + 1 < tokens.size()
+    && tokens[token + 1].type == glob_token::kind::literal;
+  const char16_t next_character = is_followed_by_literal ? tokens[token + 1].text.front() : u'\0';
+
+  switch (current.type)
+  {
+    case glob_token::kind::literal:
+    {
+      const auto& text = current.text;
+      return offset + text.size() <= path.size()
+        && equal(path.data() + offset, text.data(), text.size())
+        && match_glob(tokens, token + 1, path, offset + text.size());
+    }
+    case glob_token::kind::any:
+    {
+      return offset < path.size()
+        && path[offset] != u'/'
+        && match_glob(tokens, token + 1, path, offset + 1);
+    }
+    case glob_token::kind::star:
+    {
+      if (!is_followed_by_literal)
+      {
+        for (size_t end = offset;; end++)
+        {
+          if (match_glob(tokens, token + 1, path, end))
+            return true;
+          if (end == path.size() || path[end] == u'/')
+            return false;
+        }
+      }
+
+      for (size_t end = offset;; end++)
+      {
+        end = find_either(path, end, next_character, u'/');
+        if (end == std::u16string_view::npos)
+          return false;
+        if (path[end] == next_character && match_glob(tokens, token + 1, path, end))
+          return true;
+        // the star doesn't extend past a separator
+        if (path[end] == u'/')
+          return false;
+      }
+    }
+    case glob_token::kind::globstar:
+    {
+      if (!is_followed_by_literal)
+      {
+        for (size_t end = offset; end <= path.size(); end++)
+        {
+          if (match_glob(tokens, token + 1, path, end))
+            return true;
+        }
+        return false;
+      }
+
+      for (size_t end = offset;; end++)
+      {
+        end = find_either(path, end, next_character, next_character);
+        if (end == std::u16string_view::npos)
+          return false;
+        if (match_glob(tokens, token + 1, path, end))
+          return true;
+      }
+    }
+    case glob_token::kind::globstar_directory:
+    {
+      if (match_glob(tokens, token + 1, path, offset))
+        return true;
+
+      for (size_t separator = offset;; separator++)
+      {
+        separator = find_either(path, separator, u'/', u'/');
+        if (separator == std::u16string_view::npos)
+          return false;
+        if (match_glob(tokens, token + 1, path, separator + 1))
+          return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+} // namespace
+
+libpak::path_index::path_index(const resource& resource)
+{
+  this->entries.reserve(resource.assets.size());
+
+  for (const auto& asset : resource.assets | std::views::values)
+  {
+    const auto& header = asset.header;
+    const auto* const path_end = std::ranges::find(header.path, u'\0');
+    const std::u16string_view original_path(header.path, static_cast<size_t>(path_end - header.path));
+
+    entry entry;
+    entry.path_offset = static_cast<uint32_t>(this->paths.size());
+    entry.path_length = static_cast<uint32_t>(original_path.size());
+    entry.extension_hash = header.extension_hash;
+    entry.parent_path_hash = header.parent_path_hash;
+    entry.asset = &asset;
+
+    for (const char16_t character : original_path)
+      this->paths.push_back(normalize(character));
+
+    const auto path = this->path(entry);
+    const bool has_slash = original_path.find(u'/') != std::u16string_view::npos;
+    entry.is_backslash_separated = original_path.find(u'\\') != std::u16string_view::npos;
+
+    // the hashes are used for pruning only if they agree with the path
+    entry.is_extension_hash_trusted = hash_string(extension(path), u'/') == header.extension_hash;
+    entry.is_parent_path_hash_trusted = !(has_slash && entry.is_backslash_separated)
+      && hash_string(parent_path(path), entry.is_backslash_separated ? u'\\' : u'/')
+        == header.parent_path_hash;
+
+    this->entries.emplace_back(entry);
+  }
+
+  std::ranges::sort(
+    this->entries,
+    [](const entry& lhs, const entry& rhs)
+    {
+      return std::pair(lhs.asset->header.embedded_data_offset, lhs.asset->header.header_offset)
+        < std::pair(rhs.asset->header.embedded_data_offset, rhs.asset->header.header_offset);
+    });
+}
+
+std::vector<const libpak::asset*> libpak::path_index::match_glob(const std::u16string_view pattern) const
+{
+  const auto normalized_pattern = normalize(pattern);
+  const auto tokens = compile_glob(normalized_pattern);
+
+  // the pattern may fix the extension, e.g. `*.xml`
+  std::optional<uint32_t> expected_extension_hash;
+  const auto pattern_extension = extension(normalized_pattern);
+  if (pattern_extension.size() > 1
+    && pattern_extension.find_first_of(u"*?") == std::u16string_view::npos)
+    expected_extension_hash = hash_string(pattern_extension, u'/');
+  // a file whose name is the extension itself has none
+  const auto empty_extension_hash = hash_string({}, u'/');
+
+  // the pattern may fix the parent path, e.g. `libconfig/*.xml`
+  std::optional<uint32_t> expected_parent_path_hashes[2];
+  const auto separator = normalized_pattern.rfind(u'/');
+  const auto pattern_parent_path = parent_path(normalized_pattern);
+  const auto pattern_filename = separator == std::u16string_view::npos
+    ? std::u16string_view(normalized_pattern)
+    : std::u16string_view(normalized_pattern).substr(separator + 1);
+  if (pattern_parent_path.find_first_of(u"*?") == std::u16string_view::npos
+    && pattern_filename.find(u"**") == std::u16string_view::npos)
+  {
+    expected_parent_path_hashes[0] = hash_string(pattern_parent_path, u'/');
+    expected_parent_path_hashes[1] = hash_string(pattern_parent_path, u'\\');
+  }
+
+  std::vector<const asset*> matches;
+  for (const auto& entry : this->entries)
+  {
+    if (expected_extension_hash && entry.is_extension_hash_trusted
+      && entry.extension_hash != *expected_extension_hash
+      && entry.extension_hash != *empty_extension_hash)
+      continue;
+
+    const auto& expected_parent_path_hash = expected_parent_path_hashes[entry.is_backslash_separated];
+    if (expected_parent_path_hash && entry.is_parent_path_hash_trusted
+      && entry.parent_path_hash != *expected_parent_path_hash)
+      continue;
+
+    if (::match_glob(tokens, 0, this->path(entry), 0))
+      matches.emplace_back(entry.asset);
+  }
+
+  return matches;
+}
+
+std::vector<const libpak::asset*> libpak::path_index::match_prefix(const std::u16string_view prefix) const
+{
+  const auto normalized_prefix = normalize(prefix);
+
+  std::vector<const asset*> matches;
+  for (const auto& entry : this->entries)
+  {
+    if (entry.path_length >= normalized_prefix.size()
+      && equal(this->paths.data() + entry.path_offset, normalized_prefix.data(), normalized_prefix.size()))
+      matches.emplace_back(entry.asset);
+  }
+
+  return matches;
+}
+
+std::u16string_view libpak::path_index::path(const entry& entry) const noexcept
+{
+  return std::u16string_view(this->paths).substr(entry.path_offset, entry.path_length);
+}
@@ -0,0 +1,170 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#include "libpak/libpak.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+
+//! Largest gap between two data ranges which are still coalesced into one.
+constexpr uint64_t PREFETCH_COALESCE_GAP = 64 * 1024;
+
+#ifdef _WIN32
+//! Size of the buffer used to read the data ranges ahead.
+constexpr uint64_t PREFETCH_BUFFER_SIZE = 1024 * 1024;
+#endif
+
+/**
+ * Represents a range of the resource file.
+ */
+struct file_range
+{
+  uint64_t offset{};
+  uint64_t length{};
+};
+
+/**
+ * Hints that the ranges of the file will be read soon.
+ * @param path   Path to the file.
+ * @param ranges Ranges.
+ */
+void advise_will_need(const std::string& path, const std::vector<file_range>& ranges)
+{
+#ifdef _WIN32
+  // there is no readahead hint for unmapped files, read the ranges into the cache
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open())
+    throw std::runtime_error("failed to open resource for prefetch");
+
+  std::vector<char> buffer(PREFETCH_BUFFER_SIZE);
+  for (const auto& range : ranges)
+  {
+    file.seekg(static_cast<std::streamoff>(range.offset));
+    for (uint64_t remaining = range.length; remaining != 0 && file.good();)
+    {
+      const auto size = std::min(remaining, PREFETCH_BUFFER_SIZE);
+      file.read(buffer.data(), static_cast<std::streamsize>(size));
+      remaining -= size;
+    }
+  }
+#else
+  const int file = open(path.c_str(), O_RDONLY);
+  if (file == -1)
+    throw std::runtime_error("failed to open resource for prefetch");
+
+  for (const auto& range : ranges)
+  {
+  #ifdef __APPLE__
+    radvisory advisory{
+      .ra_offset = static_cast<off_t>(range.offset),
+      .ra_count = static_cast<int>(std::min<uint64_t>(range.length, INT32_MAX))};
+    fcntl(file, F_RDADVISE, &advisory);
+  #else
+    posix_fadvise(
+      file,
+      static_cast<off_t>(range.offset),
+      static_cast<off_t>(range.length),
+      POSIX_FADV_WILLNEED);
+  #endif
+  }
+
+  close(file);
+#endif
+}
+
+} // namespace
+
+uint64_t libpak::resource::prefetch(const std::vector<const asset*>& assets)
+{
+  std::vector<file_range> ranges;
+  ranges.reserve(assets.size());
+
+  for (const auto* asset : assets)
+  {
+    const auto& header = asset->header;
+    if (!header.are_data_embedded || header.embedded_data_length == 0)
+      continue;
+
+    ranges.emplace_back(file_range{
+      .offset = header.embedded_data_offset,
+      .length = header.embedded_data_length});
+  }
+
+  // coalesce the adjacent ranges
+  std::ranges::sort(ranges, {}, &file_range::offset);
+
+  std::vector<file_range> coalesced_ranges;
+  for (const auto& range : ranges)
+  {
+    if (!coalesced_ranges.empty())
+    {
+      auto& last = coalesced_ranges.back();
+      const uint64_t last_end = last.offset + last.length;
+      if (range.offset <= last_end + PREFETCH_COALESCE_GAP)
+      {
+        last.length = std::max(last_end, range.offset + range.length) - last.offset;
+        continue;
+      }
+    }
+
+    coalesced_ranges.emplace_back(range);
+  }
+
+  if (coalesced_ranges.empty())
+    return 0;
+
+  advise_will_need(this->resource_path, coalesced_ranges);
+
+  uint64_t hinted_bytes = 0;
+  for (const auto& range : coalesced_ranges)
+    hinted_bytes += range.length;
+  return hinted_bytes;
+}
+
+uint64_t libpak::resource::prefetch(const std::u16string_view directory)
+{
+  const auto is_separator = [](const char16_t c)
+  {
+    return c == u'/' || c == u'\\';
+  };
+
+  std::vector<const asset*> assets;
+  for (const auto& [path, asset] : this->assets)
+  {
+    // the asset must be in the directory or its subdirectories
+    if (!path.starts_with(directory))
+      continue;
+    if (!directory.empty()
+      && !is_separator(directory.back())
+      && (path.size() == directory.size() || !is_separator(path[directory.size()])))
+      continue;
+
+    assets.emplace_back(&asset);
+  }
+
+  return this->prefetch(assets);
+}
@@ -0,0 +1,182 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#include "libpak/reloadable.hpp"
+#include "libpak/algorithms.hpp"
+
+#include <stdexcept>
+
+libpak::resource_snapshot::resource_snapshot(std::string path, const bool use_arena)
+  : resource(std::move(path), true, use_arena)
+{
+}
+
+std::vector<std::byte> libpak::resource_snapshot::read_data(const asset& asset) const
+{
+  const auto& header = asset.header;
+  if (!header.are_data_embedded)
+    return {};
+
+  std::vector<std::byte> embedded_data;
+  try
+  {
+    embedded_data.resize(header.embedded_data_length);
+  }
+  catch (std::bad_alloc&)
+  {
+    throw std::runtime_error("not enough memory for embedded buffer");
+  }
+
+  {
+    // the stream is shared by the readers of the snapshot
+    std::scoped_lock lock(this->stream_mutex);
+    if (!this->resource_stream->read(
+          embedded_data.data(),
+          header.embedded_data_length,
+          header.embedded_data_offset))
+      throw std::runtime_error("couldn't read embedded data");
+  }
+
+  if (!header.are_data_compressed || embedded_data.empty())
+    return embedded_data;
+
+  std::vector<std::byte> data;
+  alg::decompress_embedded_data(
+    embedded_data.data(),
+    embedded_data.size(),
+    header.data_decompressed_length,
+    data);
+  return data;
+}
+
+libpak::reloadable_resource::reloadable_resource(std::filesystem::path path, reload_options options)
+  : path(std::move(path))
+  , options(std::move(options))
+{
+  this->publish(this->read_file_stamp());
+
+  if (this->options.poll_interval.count() > 0)
+  {
+    this->watcher = std::jthread(
+      [this](const std::stop_token& stop_token)
+      {
+        this->watch(stop_token);
+      });
+  }
+}
+
+libpak::reloadable_resource::~reloadable_resource()
+{
+  if (this->watcher.joinable())
+  {
+    this->watcher.request_stop();
+    this->watcher.join();
+  }
+}
+
+std::shared_ptr<const libpak::resource_snapshot> libpak::reloadable_resource::snapshot() const noexcept
+{
+  return this->current.load(std::memory_order_acquire);
+}
+
+void libpak::reloadable_resource::reload()
+{
+  this->publish(this->read_file_stamp());
+}
+
+uint64_t libpak::reloadable_resource::generation() const noexcept
+{
+  return this->published.load(std::memory_order_acquire);
+}
+
+libpak::reloadable_resource::file_stamp libpak::reloadable_resource::read_file_stamp() const
+{
+  std::error_code error;
+  file_stamp stamp;
+
+  stamp.write_time = std::filesystem::last_write_time(this->path, error);
+  if (error)
+    return {};
+  stamp.size = std::filesystem::file_size(this->path, error);
+  if (error)
+    return {};
+
+  return stamp;
+}
+
+void libpak::reloadable_resource::publish(const file_stamp& stamp)
+{
+  std::scoped_lock lock(this->reload_mutex);
+
+  // the snapshot is read completely before it is published
+  auto snapshot = std::make_shared<resource_snapshot>(
+    this->path.string(),
+    this->options.use_arena);
+  snapshot->read(this->options.read_data);
+
+  this->stamp = stamp;
+  this->current.store(std::move(snapshot), std::memory_order_release);
+  this->published.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void libpak::reloadable_resource::watch(const std::stop_token& stop_token)
+{
+  while (!stop_token.stop_requested())
+  {
+    {
+      std::unique_lock lock(this->watch_mutex);
+      // wakes up early when a stop is requested
+      this->watch_condition.wait_for(
+        lock,
+        stop_token,
+        this->options.poll_interval,
+        []
+        {
+          return false;
+        });
+    }
+
+    if (stop_token.stop_requested())
+      return;
+
+    const auto stamp = this->read_file_stamp();
+    {
+      std::scoped_lock lock(this->reload_mutex);
+      // the file is missing while being replaced, or hasn't changed
+      if (stamp == file_stamp{} || stamp == this->stamp)
+        continue;
+    }
+
+    try
+    {
+      this->publish(stamp);
+    }
+    catch (const std::exception& e)
+    {
+      // the file may have been read while being written, retry once it changes again
+      {
+        std::scoped_lock lock(this->reload_mutex);
+        this->stamp = stamp;
+      }
+
+      if (this->options.on_error)
+        this->options.on_error(e);
+    }
+  }
+}
@@ -0,0 +1,373 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#include "libpak/shared_index.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+  #define WIN32_LEAN_AND_MEAN
+  #define NOMINMAX
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+
+/**
+ * Hashes the asset path. The hash is stored in the segment, so it must not
+ * differ between processes or builds.
+ * @param path Asset path.
+ * @return 64-bit FNV-1a hash of the path.
+ */
+uint64_t hash_path(const std::u16string_view path) noexcept
+{
+  uint64_t hash = 0xCBF29CE484222325;
+  for (const char16_t character : path)
+  {
+    hash = (hash ^ (character & 0xFF)) * 0x100000001B3;
+    hash = (hash ^ (character >> 8)) * 0x100000001B3;
+  }
+  return hash;
+}
+
+/**
+ * @param header Asset header.
+ * @return Path of the asset header.
+ */
+std::u16string_view header_path(const libpak::asset_header& header) noexcept
+{
+  const auto* const end = std::ranges::find(header.path, u'\0');
+  return {header.path, static_cast<size_t>(end - header.path)};
+}
+
+/**
+ * @param path Path to the resource.
+ * @return Last write time of the resource.
+ */
+int64_t resource_write_time(const std::filesystem::path& path)
+{
+  return static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+}
+
+/**
+ * @param segment Segment.
+ * @return Ready flag of the segment.
+ */
+std::atomic_ref<uint32_t> ready_flag(const std::byte* segment) noexcept
+{
+  // the header is packed, the flag is accessed through its offset
+  return std::atomic_ref(*reinterpret_cast<uint32_t*>(
+    const_cast<std::byte*>(segment) + offsetof(libpak::shared_index_header, ready)));
+}
+
+/**
+ * @param offset Offset.
+ * @return Offset aligned to 8 bytes.
+ */
+uint64_t align(const uint64_t offset) noexcept
+{
+  return (offset + 7) & ~uint64_t{7};
+}
+
+} // namespace
+
+libpak::shared_index libpak::shared_index::publish(const resource& resource, const std::string& name)
+{
+  // the headers are laid out in the order of the header table
+  std::vector<const asset_header*> asset_headers;
+  asset_headers.reserve(resource.assets.size());
+  for (const auto& asset : resource.assets | std::views::values)
+    asset_headers.emplace_back(&asset.header);
+  std::ranges::sort(asset_headers, {}, &asset_header::header_offset);
+
+  shared_index_header index_header;
+  index_header.resource_size = std::filesystem::file_size(resource.resource_path);
+  index_header.resource_write_time = resource_write_time(resource.resource_path);
+  index_header.pak_header = resource.pak_header;
+  index_header.content_header = resource.content_header;
+  index_header.assets_count = static_cast<uint32_t>(asset_headers.size());
+  index_header.headers_offset = align(sizeof(shared_index_header));
+  index_header.slots_offset = align(
+    index_header.headers_offset + asset_headers.size() * sizeof(asset_header));
+  index_header.segment_size = index_header.slots_offset
+    + asset_headers.size() * sizeof(shared_index_slot);
+
+  shared_index index;
+  index.segment_size = index_header.segment_size;
+
+#ifdef _WIN32
+  const std::wstring mapping_name(name.begin(), name.end());
+  const HANDLE mapping = CreateFileMappingW(
+    INVALID_HANDLE_VALUE,
+    nullptr,
+    PAGE_READWRITE,
+    static_cast<DWORD>(index.segment_size >> 32),
+    static_cast<DWORD>(index.segment_size),
+    mapping_name.c_str());
+  if (mapping == nullptr)
+    throw std::runtime_error("failed to create shared index segment");
+  if (GetLastError() == ERROR_ALREADY_EXISTS)
+  {
+    CloseHandle(mapping);
+    throw std::runtime_error("shared index segment is mapped by another process");
+  }
+  index.mapping = mapping;
+
+  void* const segment = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, index.segment_size);
+  if (segment == nullptr)
+    throw std::runtime_error("failed to map shared index segment");
+#else
+  // replace the segment, the processes attached to the previous one keep their mapping
+  shm_unlink(name.c_str());
+  const int file = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (file == -1)
+    throw std::runtime_error("failed to create shared index segment");
+
+  if (ftruncate(file, static_cast<off_t>(index.segment_size)) != 0)
+  {
+    close(file);
+    shm_unlink(name.c_str());
+    throw std::runtime_error("failed to size shared index segment");
+  }
+
+  void* const segment = mmap(
+    nullptr,
+    index.segment_size,
+    PROT_READ | PROT_WRITE,
+    MAP_SHARED,
+    file,
+    0);
+  close(file);
+  if (segment == MAP_FAILED)
+  {
+    shm_unlink(name.c_str());
+    throw std::runtime_error("failed to map shared index segment");
+  }
+#endif
+
+  index.segment = static_cast<const std::byte*>(segment);
+  auto* const data = static_cast<std::byte*>(segment);
+
+  auto* const headers = reinterpret_cast<asset_header*>(data + index_header.headers_offset);
+  auto* const slots = reinterpret_cast<shared_index_slot*>(data + index_header.slots_offset);
+  for (uint32_t header_index = 0; header_index < index_header.assets_count; header_index++)
+  {
+    headers[header_index] = *asset_headers[header_index];
+    slots[header_index] = {
+      .path_hash = hash_path(header_path(*asset_headers[header_index])),
+      .header_index = header_index};
+  }
+
+  std::sort(
+    slots,
+    slots + index_header.assets_count,
+    [](const shared_index_slot& lhs, const shared_index_slot& rhs)
+    {
+      return lhs.path_hash < rhs.path_hash;
+    });
+
+  // the segment is marked as ready only once it is completely written
+  std::memcpy(data, &index_header, sizeof(index_header));
+  ready_flag(data).store(1, std::memory_order_release);
+
+  return index;
+}
+
+libpak::shared_index libpak::shared_index::attach(
+  const std::string& name,
+  const std::filesystem::path& resource_path)
+{
+  shared_index index;
+
+#ifdef _WIN32
+  const std::wstring mapping_name(name.begin(), name.end());
+  const HANDLE mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, mapping_name.c_str());
+  if (mapping == nullptr)
+    throw std::runtime_error("failed to open shared index segment");
+  index.mapping = mapping;
+
+  void* const segment = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (segment == nullptr)
+    throw std::runtime_error("failed to map shared index segment");
+
+  MEMORY_BASIC_INFORMATION information{};
+  VirtualQuery(segment, &information, sizeof(information));
+  index.segment = static_cast<const std::byte*>(segment);
+  index.segment_size = information.RegionSize;
+#else
+  const int file = shm_open(name.c_str(), O_RDONLY, 0);
+  if (file == -1)
+    throw std::runtime_error("failed to open shared index segment");
+
+  struct stat status{};
+  if (fstat(file, &status) != 0)
+  {
+    close(file);
+    throw std::runtime_error("failed to query shared index segment");
+  }
+
+  index.segment_size = static_cast<size_t>(status.st_size);
+  void* const segment = index.segment_size == 0
+    ? MAP_FAILED
+    : mmap(nullptr, index.segment_size, PROT_READ, MAP_SHARED, file, 0);
+  close(file);
+  if (segment == MAP_FAILED)
+    throw std::runtime_error("failed to map shared index segment");
+
+  index.segment = static_cast<const std::byte*>(segment);
+#endif
+
+  if (index.segment_size < sizeof(shared_index_header))
+    throw std::runtime_error("invalid shared index segment");
+
+  if (ready_flag(index.segment).load(std::memory_order_acquire) == 0)
+    throw std::runtime_error("shared index segment isn't ready");
+
+  const auto& header = index.header();
+  if (header.magic != shared_index_header{}.magic)
+    throw std::runtime_error("invalid shared index header");
+  if (header.version != shared_index_header{}.version)
+    throw std::runtime_error("unsupported shared index version");
+  // the offsets are checked so that the headers and the slots lie within the segment
+  // and don't overlap, no overflow is possible as the counts are 32-bit
+  if (header.segment_size > index.segment_size
+    || header.headers_offset < sizeof(shared_index_header)
+    || header.headers_offset > header.segment_size
+    || header.slots_offset > header.segment_size
+    || header.headers_offset + header.assets_count * sizeof(asset_header) > header.slots_offset
+    || header.slots_offset + header.assets_count * sizeof(shared_index_slot) > header.segment_size)
+    throw std::runtime_error("invalid shared index segment");
+
+  const auto* const slots = reinterpret_cast<const shared_index_slot*>(
+    index.segment + header.slots_offset);
+  for (uint32_t slot_index = 0; slot_index < header.assets_count; slot_index++)
+  {
+    if (slots[slot_index].header_index >= header.assets_count)
+      throw std::runtime_error("invalid shared index slot");
+  }
+
+  if (!resource_path.empty()
+    && (header.resource_size != std::filesystem::file_size(resource_path)
+      || header.resource_write_time != resource_write_time(resource_path)))
+    throw std::runtime_error("shared index is stale");
+
+  return index;
+}
+
+void libpak::shared_index::remove([[maybe_unused]] const std::string& name) noexcept
+{
+#ifndef _WIN32
+  shm_unlink(name.c_str());
+#endif
+}
+
+libpak::shared_index::shared_index(shared_index&& other) noexcept
+  : segment(std::exchange(other.segment, nullptr))
+  , segment_size(std::exchange(other.segment_size, 0))
+  , mapping(std::exchange(other.mapping, nullptr))
+{
+}
+
+libpak::shared_index& libpak::shared_index::operator=(shared_index&& other) noexcept
+{
+  if (this != &other)
+  {
+    this->unmap();
+    this->segment = std::exchange(other.segment, nullptr);
+    this->segment_size = std::exchange(other.segment_size, 0);
+    this->mapping = std::exchange(other.mapping, nullptr);
+  }
+  return *this;
+}
+
+libpak::shared_index::~shared_index()
+{
+  this->unmap();
+}
+
+const libpak::asset_header* libpak::shared_index::find(const std::u16string_view path) const noexcept
+{
+  const auto& header = this->header();
+  const auto* const slots = reinterpret_cast<const shared_index_slot*>(
+    this->segment + header.slots_offset);
+  const auto path_hash = hash_path(path);
+
+  auto slot = std::lower_bound(
+    slots,
+    slots + header.assets_count,
+    path_hash,
+    [](const shared_index_slot& slot, const uint64_t hash)
+    {
+      return slot.path_hash < hash;
+    });
+
+  // paths with the same hash are compared one by one
+  const auto asset_headers = this->headers();
+  for (; slot != slots + header.assets_count && slot->path_hash == path_hash; slot++)
+  {
+    const auto& asset_header = asset_headers[slot->header_index];
+    if (header_path(asset_header) == path)
+      return &asset_header;
+  }
+
+  return nullptr;
+}
+
+std::span<const libpak::asset_header> libpak::shared_index::headers() const noexcept
+{
+  const auto& header = this->header();
+  return {
+    reinterpret_cast<const asset_header*>(this->segment + header.headers_offset),
+    header.assets_count};
+}
+
+const libpak::shared_index_header& libpak::shared_index::header() const noexcept
+{
+  return *reinterpret_cast<const shared_index_header*>(this->segment);
+}
+
+void libpak::shared_index::unmap() noexcept
+{
+#ifdef _WIN32
+  if (this->segment != nullptr)
+    UnmapViewOfFile(this->segment);
+  if (this->mapping != nullptr)
+    CloseHandle(this->mapping);
+#else
+  if (this->segment != nullptr)
+    munmap(const_cast<std::byte*>(this->segment), this->segment_size);
+#endif
+
+  this->segment = nullptr;
+  this->segment_size = 0;
+  this->mapping = nullptr;
+}
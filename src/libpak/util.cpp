@@ -0,0 +1,75 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#include "libpak/util.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+  #define WIN32_LEAN_AND_MEAN
+  #define NOMINMAX
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+void libpak::util::sync_file(const std::filesystem::path& path)
+{
+#ifdef _WIN32
+  const HANDLE file = CreateFileW(
+    path.c_str(),
+    GENERIC_WRITE,
+    FILE_SHARE_READ | FILE_SHARE_WRITE,
+    nullptr,
+    OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL,
+    nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    throw std::runtime_error("failed to open file for sync");
+
+  const bool is_synced = FlushFileBuffers(file);
+  CloseHandle(file);
+#else
+  const int file = open(path.c_str(), O_WRONLY);
+  if (file == -1)
+    throw std::runtime_error("failed to open file for sync");
+
+  const bool is_synced = fsync(file) == 0;
+  close(file);
+#endif
+
+  if (!is_synced)
+    throw std::runtime_error("failed to sync file");
+}
+
+void libpak::util::sync_directory([[maybe_unused]] const std::filesystem::path& path)
+{
+#ifndef _WIN32
+  const int directory = open(path.empty() ? "." : path.c_str(), O_RDONLY | O_DIRECTORY);
+  if (directory == -1)
+    throw std::runtime_error("failed to open directory for sync");
+
+  const bool is_synced = fsync(directory) == 0;
+  close(directory);
+
+  if (!is_synced)
+    throw std::runtime_error("failed to sync directory");
+#endif
+}
@@ -0,0 +1,237 @@
+/**
+ * libpak - library for PAK manipulation
+ * Copyright (C) 2026 Story Of Alicia
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **/
+
+#include "libpak/writer.hpp"
+#include "libpak/algorithms.hpp"
+#include "libpak/util.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <format>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+
+//! Size of the buffer used when writing the resource.
+constexpr size_t WRITE_BUFFER_SIZE = 1024 * 1024;
+
+//! Number of names tried for the staging file.
+constexpr int STAGING_FILE_ATTEMPTS = 16;
+
+//! Offset of the header table.
+constexpr int64_t HEADER_TABLE_OFFSET = libpak::PAK_CONTENT_SECTOR + sizeof(libpak::content_header);
+
+/**
+ * @param assets_count Number of assets.
+ * @return End of the header table.
+ */
+int64_t header_table_end(const size_t assets_count)
+{
+  return HEADER_TABLE_OFFSET + static_cast<int64_t>(assets_count * sizeof(libpak::asset_header));
+}
+
+/**
+ * Creates a staging file with a unique name next to the target. The file is created
+ * exclusively, so that concurrent writers to the same target never share it.
+ * @param target_path Path to the target.
+ * @return Path to the staging file.
+ * @throws std::runtime_error
+ */
+std::filesystem::path create_staging_file(const std::filesystem::path& target_path)
+{
+  std::random_device device;
+  std::mt19937_64 generator(
+    (static_cast<uint64_t>(device()) << 32)
+    ^ device()
+    ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+
+  for (int attempt = 0; attempt < STAGING_FILE_ATTEMPTS; attempt++)
+  {
+    auto path = target_path;
+    path += std::format(".{:016x}.tmp", generator());
+
+    // the exclusive mode fails if the file already exists
+#ifdef _WIN32
+    FILE* const file = _wfopen(path.c_str(), L"wbx");
+#else
+    FILE* const file = std::fopen(path.c_str(), "wbx");
+#endif
+    if (file != nullptr)
+    {
+      std::fclose(file);
+      return path;
+    }
+
+    if (errno != EEXIST)
+      throw std::runtime_error("failed to create staging file");
+  }
+
+  throw std::runtime_error("failed to create a unique staging file");
+}
+
+} // namespace
+
+libpak::writer::writer(std::filesystem::path path, const size_t assets_count)
+  : target_path(std::move(path))
+  , write_buffer(WRITE_BUFFER_SIZE)
+  , assets_count(assets_count)
+{
+  // the resource is staged in a temporary file
+  // and replaces the target only once it is complete
+  this->staging_path = create_staging_file(this->target_path);
+
+  this->output = std::make_shared<std::ofstream>();
+  this->output->rdbuf()->pubsetbuf(
+    this->write_buffer.data(),
+    static_cast<std::streamsize>(this->write_buffer.size()));
+  this->output->open(this->staging_path, std::ios::binary | std::ios::trunc);
+  if (!this->output->is_open())
+  {
+    std::error_code error;
+    std::filesystem::remove(this->staging_path, error);
+    throw std::runtime_error("failed to open staging file");
+  }
+
+  this->header_table.reserve(assets_count);
+
+  // The data sector is moved only if the header table doesn't fit in front of it.
+  const int64_t data_offset = std::max<int64_t>(
+    PAK_DATA_SECTOR,
+    header_table_end(assets_count) + sizeof(data_header));
+  this->output->seekp(data_offset);
+}
+
+libpak::writer::~writer()
+{
+  if (this->is_committed)
+    return;
+
+  this->output->close();
+
+  std::error_code error;
+  std::filesystem::remove(this->staging_path, error);
+}
+
+void libpak::writer::write_data(asset_header& header, const std::byte* const data, const uint64_t length)
+{
+  header.embedded_data_offset = static_cast<uint32_t>(this->output->tellp());
+  header.embedded_data_length = static_cast<uint32_t>(length);
+
+  this->output->write(
+    reinterpret_cast<const char*>(data),
+    static_cast<std::streamsize>(length));
+  if (!this->output->good())
+    throw std::runtime_error("failed to write embedded data");
+}
+
+void libpak::writer::add_header(asset_header& header)
+{
+  if (this->header_table.size() == this->assets_count)
+    throw std::runtime_error("more assets written than declared");
+
+  header.header_offset = static_cast<uint32_t>(
+    HEADER_TABLE_OFFSET + this->header_table.size() * sizeof(asset_header));
+  update_header_hashes(header);
+
+  this->header_table.emplace_back(header);
+}
+
+void libpak::writer::commit(
+  pak_header& pak_header,
+  content_header& content_header,
+  const data_header& data_header)
+{
+  if (this->header_table.size() != this->assets_count)
+    throw std::runtime_error("less assets written than declared");
+
+  const auto assets_count = static_cast<uint32_t>(this->assets_count);
+
+  // Update the content header
+  content_header.assets_count = assets_count;
+
+  // Update the intro PAKS header assets counts
+  pak_header.assets_count = assets_count;
+  pak_header.used_assets_count = assets_count;
+  pak_header.deleted_assets_count = 0;
+
+  pak_header.file_size = static_cast<uint32_t>(
+    header_table_end(this->assets_count) + sizeof(data_header));
+
+  // Write the intro PAKS header
+  this->output->seekp(0);
+  this->output->write(reinterpret_cast<const char*>(&pak_header), sizeof(pak_header));
+  if (!this->output->good())
+    throw std::runtime_error("failed to write pak header");
+
+  // write the content header
+  this->output->seekp(PAK_CONTENT_SECTOR);
+  this->output->write(reinterpret_cast<const char*>(&content_header), sizeof(content_header));
+  if (!this->output->good())
+    throw std::runtime_error("failed to write content header");
+
+  // write the header table
+  this->output->write(
+    reinterpret_cast<const char*>(this->header_table.data()),
+    static_cast<std::streamsize>(this->header_table.size() * sizeof(asset_header)));
+  if (!this->output->good())
+    throw std::runtime_error("failed to write asset headers");
+
+  this->output->write(reinterpret_cast<const char*>(&data_header), sizeof(data_header));
+  if (!this->output->good())
+    throw std::runtime_error("failed to write data header");
+
+  this->output->close();
+  if (this->output->fail())
+    throw std::runtime_error("failed to flush staging file");
+
+  // persist the staging file before it replaces the target
+  util::sync_file(this->staging_path);
+  std::filesystem::rename(this->staging_path, this->target_path);
+  util::sync_directory(this->target_path.parent_path());
+
+  this->is_committed = true;
+}
+
+void libpak::writer::update_header_hashes(asset_header& header)
+{
+  const std::filesystem::path path(header.path);
+
+  // update path hash
+  const auto path_string = path.string();
+  // path length includes the zero terminator
+  header.path_length = static_cast<uint32_t>(
+    path_string.length() + 1);
+  header.path_hash = alg::capitalized_string_crc32(path_string);
+
+  // update filename hash
+  const std::string filename_string = path.filename().string();
+  header.filename_hash = alg::capitalized_string_crc32(filename_string);
+
+  // update extension hash
+  const std::string extension_string = path.extension().string();
+  header.extension_hash = alg::capitalized_string_crc32(extension_string);
+
+  // update parent path hash
+  const std::string parent_path_string = path.parent_path().string();
+  header.parent_path_hash = alg::capitalized_string_crc32(parent_path_string);
+}